@@ -0,0 +1,63 @@
+/**
+ * @file hrglib/columnar_import.hpp
+ * @brief Bulk construction of relations and their hierarchy from arrays.
+ */
+#pragma once
+#include "hrglib/types.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/string.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Nodes of one relation given as columns of `rows` elements each, as produced by
+ *     tokenizers and similar array-oriented stages.
+ *
+ * The arrays are only read during `import_columns()` and are not owned.
+ */
+struct relation_columns {
+    //! @brief Values of integral feature, eg. `F::start_pos`.
+    struct integral_column {
+        feature_name feature;
+        const std::uint64_t* values;
+    };
+    //! @brief Textual values of other features, parsed as when loading YAML.
+    struct text_column {
+        feature_name feature;
+        const string* values;
+    };
+
+    relation_name relation;
+    std::size_t rows = 0;
+    /**
+     * @brief Relation of the parents, imported earlier in the same call, and row of the parent
+     *     of each node in it (`-1` for none). Children of a parent must be consecutive, so
+     *     that they form its child span.
+     */
+    relation_name parent_relation = relation_name::INVALID;
+    const std::int64_t* parents = nullptr;
+    std::vector<integral_column> integral;
+    std::vector<text_column> text;
+};
+
+/**
+ * @brief Append the nodes given by @p columns to relations of @p g, in order, setting their
+ *     features and linking them to their parents.
+ *
+ * Parent links are validated once per relation rather than once per node, and written
+ * without the per-link unlinking done by `node::set_parent()`. All of @p columns are checked
+ * and their text values parsed before any node is added, so if this throws, @p g is left
+ * as it was, except that the relations named may have been created empty.
+ *
+ * @throw error::bad_relation if `relation_validator()` of @p g rejects any parent relation.
+ * @throw std::invalid_argument if parent relation was not imported before, children of
+ *     some parent are not consecutive, or integral column has non-integral feature.
+ * @throw std::out_of_range if any parent row is beyond its relation's rows.
+ * @throw error::invalid_feature_type if any text value is not valid for its feature.
+ */
+void import_columns(graph& g, const std::vector<relation_columns>& columns);
+}  // namespace hrglib
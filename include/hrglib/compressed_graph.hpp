@@ -0,0 +1,51 @@
+/**
+ * @file hrglib/compressed_graph.hpp
+ * @brief Definition of `hrglib::compressed_graph`, compact in-memory encoding of `graph`.
+ */
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/string.hpp"
+
+#include <cstddef>
+#include <utility>
+
+namespace hrglib {
+/**
+ * @brief Immutable, compact encoding of a `graph`, suitable for keeping many graphs cached
+ *     in memory and materializing them on demand.
+ *
+ * Obtained with `graph::compress()`. Nodes are numbered in relation order, so links are coded
+ * as small varint deltas between node numbers; string feature values are interned, integral
+ * ones are varint-coded and handles sharing contents refer to the first handle instead of
+ * repeating the features. The encoding is tied to the relation and feature lists of the
+ * library build which produced it.
+ */
+class compressed_graph {
+    string data_;
+
+    friend hrglib::graph;
+    explicit compressed_graph(string data) noexcept: data_{std::move(data)} {}
+
+public:
+    //! @return number of bytes taken by the encoded graph.
+    std::size_t size() const noexcept { return data_.size(); }
+    //! @return the encoded graph, eg. for persisting it.
+    string_view bytes() const noexcept { return data_; }
+    //! @brief Adopt bytes obtained from `bytes()` of another instance.
+    //! @note Validity of @p bytes is checked only on `decompress()`.
+    static compressed_graph from_bytes(string bytes) noexcept {
+        return compressed_graph{std::move(bytes)};
+    }
+
+    /**
+     * @brief Recreate live graph with same relations, nodes, links and features.
+     *
+     * Links are restored as they were, without consulting relation validator of the graph.
+     *
+     * @param b configures the created graph; the name mappers are not used.
+     * @throw error::parsing_error if the encoded data is malformed.
+     */
+    hrglib::graph decompress(optional<hrglib::graph::builder> b = nullopt) const;
+};
+}  // namespace hrglib
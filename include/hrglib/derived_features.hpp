@@ -0,0 +1,209 @@
+/**
+ * @file hrglib/derived_features.hpp
+ * @brief Definition of `hrglib::derived_features`, memoizing cache of feature functions.
+ */
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/feature_traits.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/any.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace hrglib {
+//! @brief Handle of function of type @p T registered in `derived_features`.
+template<typename T>
+class derived_feature {
+    std::size_t index_;
+    friend class derived_features;
+    constexpr explicit derived_feature(std::size_t index) noexcept: index_{index} {}
+
+public:
+    using value_type = T;
+    constexpr std::size_t index() const noexcept { return index_; }
+};
+
+/**
+ * @brief Computes registered feature functions on demand and memoizes their results per node.
+ *
+ * Feature functions read the graph through `reader`, which records what was read: links,
+ * relation membership, features and other derived features. A memoized value is dropped
+ * precisely when any of these changes, as reported by the graph mutation listeners; values
+ * of derived features depending on it are dropped too.
+ * Reads bypassing the `reader` are not tracked. Each source is recorded once per value, and
+ * dropping the value unregisters it from all its sources, so the bookkeeping stays
+ * proportional to the number of memoized values.
+ */
+class derived_features: private detail::mutation_listener {
+public:
+    class reader;
+
+    //! @brief Counters for tuning the use of the cache.
+    struct statistics {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        //! @brief Memoized values dropped because of graph mutations.
+        std::size_t invalidations = 0;
+
+        //! @return ratio of hits to all lookups, `0` if there were none.
+        double hit_rate() const noexcept {
+            const auto total = hits + misses;
+            return total != 0 ? static_cast<double>(hits) / total : 0.;
+        }
+    };
+
+private:
+    //! @brief Memoized value, identified by function index and node.
+    struct entry_key {
+        std::size_t function;
+        const node* handle;
+        bool operator==(const entry_key& o) const noexcept {
+            return function == o.function && handle == o.handle;
+        }
+    };
+    //! @brief Something a memoized value was computed from, identified by the object and a slot
+    //!     in it: link or other memoized value (node), feature or relation membership (features
+    //!     of the contents) or first/last node (relation).
+    struct source_key {
+        const void* object;
+        std::size_t slot;
+        bool operator==(const source_key& o) const noexcept {
+            return object == o.object && slot == o.slot;
+        }
+    };
+    struct key_hash {
+        static std::size_t combine(const void* object, std::size_t slot) noexcept {
+            return std::hash<const void*>{}(object) ^ (slot * 0x9e3779b97f4a7c15ull);
+        }
+        std::size_t operator()(const entry_key& k) const noexcept { return combine(k.handle, k.function); }
+        std::size_t operator()(const source_key& k) const noexcept { return combine(k.object, k.slot); }
+    };
+
+    using function_type = std::function<any(const node&, reader&)>;
+
+    graph& graph_;
+    std::vector<function_type> functions_;
+    std::vector<statistics> stats_;
+    std::unordered_map<entry_key, any, key_hash> values_;
+    std::unordered_map<source_key, std::unordered_set<entry_key, key_hash>, key_hash> dependents_;
+    //! @brief Inverse of `dependents_`, so that dropped value leaves all the sets it's in.
+    std::unordered_map<entry_key, std::vector<source_key>, key_hash> sources_;
+    //! @brief Values being computed, for detecting functions depending on themselves.
+    std::unordered_set<entry_key, key_hash> computing_;
+
+    //! @brief Slot of node `source_key` for value of function @p index memoized at the node;
+    //!     the slots below are taken by the links.
+    static constexpr std::size_t derived_slot(std::size_t index) noexcept {
+        return static_cast<std::size_t>(pivot::COUNT) + index;
+    }
+
+    const any& get_(std::size_t function, const node& n);
+    void depend_(source_key source, const entry_key& dependent);
+    void forget_(const entry_key& key);
+    void drop_(const entry_key& key);
+    void invalidate_(source_key source);
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+    void relation_changing(relation& r) override;
+    void feature_changing(node& n, feature_name feat) override;
+
+public:
+    //! @brief Tracks reads of a feature function, see `derived_features`.
+    class reader {
+        derived_features& cache_;
+        const entry_key dependent_;
+
+        friend derived_features;
+        reader(derived_features& cache, const entry_key& dependent) noexcept:
+            cache_{cache},
+            dependent_{dependent}
+        {}
+
+    public:
+        //! @brief Navigation with null propagation of `node_navigator`.
+        //! @{
+        node::const_navigator link(node::const_navigator n, pivot p);
+        node::const_navigator next(node::const_navigator n) { return link(n, pivot::next); }
+        node::const_navigator prev(node::const_navigator n) { return link(n, pivot::prev); }
+        node::const_navigator parent(node::const_navigator n) { return link(n, pivot::parent); }
+        node::const_navigator first_child(node::const_navigator n) { return link(n, pivot::first_child); }
+        node::const_navigator last_child(node::const_navigator n) { return link(n, pivot::last_child); }
+        node::const_navigator as(node::const_navigator n, relation_name rel);
+        //! @}
+
+        node::const_navigator first(const relation& r);
+        node::const_navigator last(const relation& r);
+
+        //! @return optional value of @p feat of @p n; empty if @p n is null.
+        optional<const any&> get(node::const_navigator n, feature_name feat);
+        //! @copydoc get(node::const_navigator, feature_name)
+        template<feature_name feat>
+        optional<const feature_t<feat>&> get(node::const_navigator n) {
+            if (auto v = get(n, feat)) {
+                return {any_cast<const feature_t<feat>&>(*v)};
+            }
+            return {};
+        }
+        //! @return value of derived feature @p f of @p n, computed on demand.
+        template<typename T>
+        const T& get(derived_feature<T> f, const node& n) {
+            cache_.depend_({&n, derived_slot(f.index())}, dependent_);
+            return any_cast<const T&>(cache_.get_(f.index(), n));
+        }
+    };
+
+    //! @brief Attach the cache to @p g, installing mutation listener; @p g must outlive it.
+    explicit derived_features(graph& g);
+    derived_features(const derived_features&) = delete;
+    derived_features& operator=(const derived_features&) = delete;
+    ~derived_features() override;
+
+    /**
+     * @brief Register feature function @p f.
+     * @param f callable as `T(const node&, reader&)`.
+     * @return handle for accessing the values of @p f.
+     */
+    template<typename T, typename Function>
+    derived_feature<T> define(Function f) {
+        functions_.emplace_back([f = std::move(f)](const node& n, reader& r) -> any {
+            return T(f(n, r));
+        });
+        stats_.emplace_back();
+        return derived_feature<T>{functions_.size() - 1};
+    }
+
+    /**
+     * @return value of @p f for @p n, memoized or computed now.
+     * @throw std::logic_error if computing the value needs the value itself.
+     */
+    template<typename T>
+    const T& get(derived_feature<T> f, const node& n) {
+        return any_cast<const T&>(get_(f.index(), n));
+    }
+
+    //! @return counters of function @p f.
+    template<typename T>
+    const statistics& stats(derived_feature<T> f) const noexcept { return stats_[f.index()]; }
+    //! @return counters summed over all functions.
+    statistics stats() const noexcept;
+    //! @return number of memoized values.
+    std::size_t size() const noexcept { return values_.size(); }
+    //! @return number of recorded dependencies of the memoized values.
+    std::size_t dependencies() const noexcept;
+    //! @brief Drop all memoized values; counters are kept.
+    void clear() noexcept;
+};
+}  // namespace hrglib
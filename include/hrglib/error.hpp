@@ -13,6 +13,7 @@
 #include <typeinfo>
 #include <type_traits>
 #include <iosfwd>
+#include <vector>
 
 namespace hrglib {
 //! @brief Exception classes and error-handling utilities.
@@ -114,4 +115,23 @@ struct invalid_relation_name: parsing_error {
     {}
 };
 
+struct invalid_path: parsing_error {
+    const string path;
+    explicit invalid_path(string path, const string& reason):
+        parsing_error{str(format("path \"%1%\" is invalid: %2%") % path % reason)},
+        path{std::move(path)}
+    {}
+};
+
+//! @brief Exception thrown by `graph::validate()`, listing all the inconsistencies found.
+struct invalid_graph: std::runtime_error {
+    const std::vector<string> violations;
+    explicit invalid_graph(std::vector<string> violations);
+};
+
+//! @brief Exception thrown when shared graph can't be published or taken over.
+struct bad_handoff: std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
 }}  // namespace hrglib::error
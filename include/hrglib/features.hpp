@@ -9,6 +9,7 @@
 #include "hrglib/string.hpp"
 #include "hrglib/any.hpp"
 #include "hrglib/map_find.hpp"
+#include "hrglib/types.hpp"
 
 #ifdef HRGLIB_YAMLCPP_PUBLIC
 #include <yaml-cpp/node/node.h>
@@ -27,6 +28,27 @@ namespace hrglib {
  */
 class features: private std::unordered_map<feature_name, any> {
     using base = std::unordered_map<feature_name, any>;
+    friend hrglib::node;
+    friend detail::graph_access;
+
+    //! @brief Handle of the node owning these features; set only while the owning `graph`
+    //!     has mutation listeners installed and used solely for routing change notifications.
+    hrglib::node* owner_ = nullptr;
+
+    //! @brief Report upcoming write or removal of @p feat to the owning graph, if anybody listens.
+    void changing_(feature_name feat) {
+        if (owner_ != nullptr) {
+            notify_changing_(feat);
+        }
+    }
+    void notify_changing_(feature_name feat);
+    //! @brief Report upcoming change of all features present either here or in @p other.
+    void changing_all_(const features* other = nullptr) {
+        if (owner_ != nullptr) {
+            notify_changing_all_(other);
+        }
+    }
+    void notify_changing_all_(const features* other);
 
     //! @brief Insert-or-access operation which ensures that `any` instance inserted at
     //!     @p feat is always initialized to contain `feature_t<feat>`, thus avoiding
@@ -40,7 +62,7 @@ class features: private std::unordered_map<feature_name, any> {
         }
     }
 
-    //! @brief Common implementation of both non-static (const and non-const) @c get() members.
+    //! @brief Common implementation of @c get() and @c peek() members.
     //! @tparam Features (possibly const) `features` whose constness will be applied to the
     //!     returned `optional`.
     //! @return reference to value stored at @p feat or `nullopt` if no such feature.
@@ -54,6 +76,28 @@ class features: private std::unordered_map<feature_name, any> {
     }
 
 public:
+    features() = default;
+    //! @brief Copies the values only; the copy is not owned by any node.
+    features(const features& other): base{other} {}
+    //! @copydoc features(const features&)
+    features(features&& other) noexcept: base{std::move(other)} {}
+    //! @brief Replace the values, keeping ownership of this instance intact.
+    features& operator=(const features& other) {
+        if (this != &other) {
+            changing_all_(&other);
+            base::operator=(other);
+        }
+        return *this;
+    }
+    //! @copydoc operator=(const features&)
+    features& operator=(features&& other) {
+        if (this != &other) {
+            changing_all_(&other);
+            base::operator=(std::move(other));
+        }
+        return *this;
+    }
+
     //! Feature presence check.
     //! @param feat to check.
     //! @return `true` if @p feat is present.
@@ -66,11 +110,17 @@ public:
      * type `feature_t<feat>` will be inserted and its reference will be used. This allows to use
      * the result as l-value in assignment operation.
      *
+     * Every call is reported to the graph as a write of @p feat, even if the result is only
+     * read; use `get()` on const instance or `peek()` for reading.
+     *
      * @tparam feat Compile-time constant specifing feature label to select.
      * @return `feature_t<feat>&`
      */
     template<feature_name feat>
-    feature_t<feat>& at() { return any_cast<feature_t<feat>&>(at_<feat>()); }
+    feature_t<feat>& at() {
+        changing_(feat);
+        return any_cast<feature_t<feat>&>(at_<feat>());
+    }
     /**
      * @brief Optional immutable acces to raw `any` container at runtime-selectable @p feat.
      *
@@ -89,11 +139,30 @@ public:
     /**
      * @brief Optional acces to feature value at compile-time selectable @p feat.
      *
+     * Mutable access to existing value is reported to the graph as a write, even if the
+     * value is only read; use `peek()` for reading through non-const instance.
+     *
      * @tparam feat to access.
      * @return `optional<feature_t<feat>&>`
      */
     template<feature_name feat>
-    optional<feature_t<feat>&> get() { return get_<feat>(*this); }
+    optional<feature_t<feat>&> get() {
+        if (owner_ != nullptr && has(feat)) {
+            notify_changing_(feat);
+        }
+        return get_<feat>(*this);
+    }
+    /**
+     * @brief Optional immutable acces to feature value at compile-time selectable @p feat,
+     *     which is never reported as a write.
+     *
+     * Same as `get()` on const instance.
+     *
+     * @tparam feat to access.
+     * @return `optional<const feature_t<feat>&>`
+     */
+    template<feature_name feat>
+    optional<const feature_t<feat>&> peek() const { return get_<feat>(*this); }
     /**
      * @brief Set value at compile-time selectable @p feat in a type-safe way.
      *
@@ -116,6 +185,7 @@ public:
     template<feature_name feat>
     optional<feature_t<feat>> remove() {
         if (auto it = base::find(feat); it != base::end()) {
+            changing_(feat);
             optional<feature_t<feat>> res = any_cast<feature_t<feat>&&>(std::move(it->second));
             base::erase(it);
             return res;
@@ -139,11 +209,40 @@ public:
 
     const_iterator find(feature_name key) const { return base::find(key); }
 
+    /**
+     * @brief Insert or overwrite all the values present in @p other.
+     *
+     * Runtime counterpart of `set()`; values in @p other are already properly
+     * typed so invariants are kept.
+     *
+     * @return `*this` for builder-like chaining.
+     */
+    features& update(features other) {
+        for (auto&& kv: static_cast<base&>(other)) {
+            changing_(kv.first);
+            base::insert_or_assign(kv.first, std::move(kv.second));
+        }
+        return *this;
+    }
+
     // std::unordered_map APIs which don't break features invariants.
-    using base::erase;
+    base::size_type erase(feature_name feat) {
+        if (base::count(feat) == 0) {
+            return 0;
+        }
+        changing_(feat);
+        return base::erase(feat);
+    }
+    const_iterator erase(const_iterator pos) {
+        changing_(pos->first);
+        return base::erase(pos);
+    }
+    void clear() {
+        changing_all_();
+        base::clear();
+    }
     using base::size;
     using base::empty;
-    using base::clear;
 
     //! @brief Type of function mapping textual feature name labels to `feature` enum constants.
     using name_mapper_type = std::function<feature_name(string_view)>;
@@ -167,6 +266,13 @@ public:
             const YAML::Node& document,
             const name_mapper_type& feature_name_mapper = nullptr);
 
+    //! @brief Parse features from @p document, skipping those not kept by @p proj;
+    //!     values of skipped features are not converted at all.
+    static features from_yaml(
+            const YAML::Node& document,
+            const projection& proj,
+            const name_mapper_type& feature_name_mapper = nullptr);
+
     friend YAML::Emitter& operator << (YAML::Emitter& lhs, const features& rhs);
 #endif
 
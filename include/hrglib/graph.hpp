@@ -12,6 +12,8 @@
 #include "hrglib/map_find.hpp"
 #include "hrglib/type_traits.hpp"
 #include "hrglib/features.hpp"
+#include "hrglib/projection.hpp"
+#include "hrglib/mutation_listener.hpp"
 
 #ifdef HRGLIB_YAMLCPP_PUBLIC
 #include <yaml-cpp/node/node.h>
@@ -19,6 +21,8 @@
 #endif
 
 #include <unordered_map>
+#include <vector>
+#include <utility>
 #include <iosfwd>
 
 namespace hrglib {
@@ -27,9 +31,37 @@ class graph: private std::unordered_map<relation_name, unique_ptr<relation>> {
     using base = std::unordered_map<relation_name, unique_ptr<relation>>;
     const node::factory_type node_factory_;
     const node::relation_validator_type relation_validator_;
+    //! @brief Whether `relation_validator_` is `node::default_relation_validator`, which
+    //!     nodes then bypass for a lookup in the `is_valid_link()` table.
+    const bool default_relation_validator_;
     const relation::factory_type relation_factory_;
     const relation::name_mapper_type relation_name_mapper_;
     const features::name_mapper_type feature_name_mapper_;
+    //! @brief Whether link setters skip the relation checks, left to `validate()`.
+    bool deferred_validation_;
+    //! @brief Installed mutation listeners; empty unless some facility tracks changes.
+    std::vector<detail::mutation_listener*> listeners_;
+    struct journal_deleter {
+        void operator()(hrglib::journal* j) const noexcept;
+    };
+    unique_ptr<hrglib::journal, journal_deleter> journal_;
+
+    friend hrglib::node;
+    friend hrglib::relation;
+    friend hrglib::features;
+    friend detail::graph_access;
+
+    bool listened_() const noexcept { return !listeners_.empty(); }
+    template<typename... Params, typename... Args>
+    void notify_(void (detail::mutation_listener::*callback)(Params...), Args&&... args) const {
+        for (auto l: listeners_) {
+            (l->*callback)(args...);
+        }
+    }
+    //! @return @p g, if it can be moved.
+    static graph& movable_(graph& g);
+    void add_listener_(detail::mutation_listener& l);
+    void remove_listener_(detail::mutation_listener& l) noexcept;
 
     template<typename Relation = relation, class Utterance>
     static optional<copy_const_t<Utterance, Relation>&> get_(Utterance& u, relation_name rel) noexcept {
@@ -46,7 +78,8 @@ public:
             node::relation_validator_type relation_validator = nullptr,
             relation::factory_type relation_factory = nullptr,
             relation::name_mapper_type relation_name_mapper = nullptr,
-            features::name_mapper_type feature_name_mapper = nullptr
+            features::name_mapper_type feature_name_mapper = nullptr,
+            bool deferred_validation = false
     ):
         node_factory_{ node_factory
             ? std::move(node_factory)
@@ -56,6 +89,9 @@ public:
             ? std::move(relation_validator)
             : node::default_relation_validator{}
         },
+        default_relation_validator_{
+            relation_validator_.target<node::default_relation_validator>() != nullptr
+        },
         relation_factory_{ relation_factory
             ? std::move(relation_factory)
             : relation::default_factory{}
@@ -67,15 +103,25 @@ public:
         feature_name_mapper_{ feature_name_mapper
             ? std::move(feature_name_mapper)
             : features::DEFAULT_NAME_MAPPER
-        }
+        },
+        deferred_validation_{deferred_validation}
     {}
 
+    /**
+     * @brief Take over the relations and the journal of @p other, leaving it empty.
+     * @throw std::invalid_argument if mutation listeners other than the journal, eg.
+     *     `graph_observer`, are attached to @p other, as they stay bound to it.
+     */
+    graph(graph&& other);
+    ~graph();
+
     struct builder {
         node::factory_type node_factory = nullptr;
         node::relation_validator_type relation_validator = nullptr;
         relation::factory_type relation_factory = nullptr;
         relation::name_mapper_type relation_name_mapper = nullptr;
         features::name_mapper_type feature_name_mapper = nullptr;
+        bool deferred_validation = false;
 
         builder& with_node_factory(node::factory_type nf) {
             node_factory = std::move(nf);
@@ -97,6 +143,12 @@ public:
             feature_name_mapper = std::move(fnm);
             return *this;
         }
+        //! @brief Build graph with `validation_deferred()`, eg. for bulk construction or
+        //!     loading of trusted data; the loaders validate it once loaded.
+        builder& with_deferred_validation(bool deferred = true) {
+            deferred_validation = deferred;
+            return *this;
+        }
 
         graph build() const & {
             return graph{
@@ -105,6 +157,7 @@ public:
                 relation_factory,
                 relation_name_mapper,
                 feature_name_mapper,
+                deferred_validation,
             };
         }
 
@@ -115,6 +168,7 @@ public:
                 std::move(relation_factory),
                 std::move(relation_name_mapper),
                 std::move(feature_name_mapper),
+                deferred_validation,
             };
         }
     };
@@ -151,21 +205,116 @@ public:
     constexpr const relation::name_mapper_type& relation_name_mapper() const noexcept { return relation_name_mapper_; }
     constexpr const features::name_mapper_type& feature_name_mapper() const noexcept { return feature_name_mapper_; }
 
+    //! @brief Visit all the relations of this graph in unspecified order.
+    template<typename Visitor>
+    void for_each_relation(Visitor&& visit) const {
+        for (auto&& kv: static_cast<const base&>(*this)) {
+            visit(std::as_const(*kv.second));
+        }
+    }
+    //! @copydoc for_each_relation() const
+    template<typename Visitor>
+    void for_each_relation(Visitor&& visit) {
+        for (auto&& kv: static_cast<base&>(*this)) {
+            visit(*kv.second);
+        }
+    }
+
+    /**
+     * @brief Start recording mutations of this graph in a `journal`.
+     *
+     * Nodes existing at this point become the base snapshot the journal is relative to.
+     * Graphs without journal don't pay for journaling at all.
+     *
+     * @return the active journal (the existing one if already started).
+     */
+    hrglib::journal& start_journal();
+    //! @brief Stop recording mutations and discard the journal.
+    void stop_journal() noexcept;
+    optional<const hrglib::journal&> journal() const noexcept;
+    optional<hrglib::journal&> journal() noexcept;
+
+    /**
+     * @brief Encode this graph into compact immutable form, see `compressed_graph`.
+     *
+     * Use `compressed_graph::decompress()` to get a live graph back.
+     */
+    compressed_graph compress() const;
+
+    /**
+     * @brief Whether the link setters (`node::set_next()`, `node::set_parent()`,
+     *     `relation::set_first()` etc.) skip checking the relations of linked nodes, which
+     *     is left to single `validate()` call once the graph is complete.
+     */
+    bool validation_deferred() const noexcept { return deferred_validation_; }
+    void defer_validation(bool deferred = true) noexcept { deferred_validation_ = deferred; }
+    /**
+     * @brief Check the whole graph at once: that sequences and relation ends stay within
+     *     their relation, that parent and child links fit the relation validator and
+     *     point back, and that `next` and `prev` links are symmetric.
+     * @throw error::invalid_graph listing all the violations found.
+     */
+    void validate() const;
+
+    //! @brief Scope of speculative edits which may be rolled back, see `transaction.hpp`.
+    class transaction;
+
+    //! @brief What was freed by `collect()`.
+    struct collect_stats {
+        //! @brief Node handles erased.
+        std::size_t nodes = 0;
+        //! @brief Shared contents (features) released with their last handle.
+        std::size_t contents = 0;
+    };
+    /**
+     * @brief Erase node handles not reachable by any links from the `first()` and `last()`
+     *     nodes of the relations, such as loose nodes left by `relation::create()`.
+     *
+     * Marks along all the links of each node (`next`, `prev`, `parent`, `first_child` and
+     * `last_child`) in time linear in the number of nodes, then sweeps the rest.
+     */
+    collect_stats collect();
+
+    /**
+     * @brief Move all the nodes of @p other into this graph, appending the sequence of each
+     *     of its relations after the sequence of the same relation here.
+     *
+     * Nodes and their shared contents change owner rather than being copied, so references
+     * to them stay valid and only their relation backreferences and `node::id()`s change.
+     * Takes time linear in the number of nodes moved; @p other is left empty. Mutation
+     * listeners of this graph are told of the moved nodes as created, with their links and
+     * features as changing, before the sequences are joined.
+     * @throw std::invalid_argument if @p other is this graph, has mutation listeners (such
+     *     as a journal) or its relations are of other types than the ones of this graph.
+     * @throw error::bad_relation if a relation of @p other is not supported by this graph.
+     */
+    void append_graph(graph&& other);
+
     builder to_builder() const {
         return builder{}
             .with_feature_name_mapper(feature_name_mapper())
             .with_node_factory(node_factory())
             .with_relation_factory(relation_factory())
             .with_relation_name_mapper(relation_name_mapper())
-            .with_relation_validator(relation_validator());
+            .with_relation_validator(relation_validator())
+            .with_deferred_validation(validation_deferred());
     }
 
     static graph from_file(string_view path, optional<builder> b = nullopt);
     static graph from_stream(std::istream& is, optional<builder> b = nullopt);
     static graph from_string(string_view yaml, optional<builder> b = nullopt);
 
+    //! @brief Loaders materializing only relations and features kept by @p proj.
+    //!     Links into dropped relations are cut, nodes without any kept relation are skipped.
+    //! @{
+    static graph from_file(string_view path, const projection& proj, optional<builder> b = nullopt);
+    static graph from_stream(std::istream& is, const projection& proj, optional<builder> b = nullopt);
+    static graph from_string(string_view yaml, const projection& proj, optional<builder> b = nullopt);
+    //! @}
+
 #ifdef HRGLIB_YAMLCPP_PUBLIC
     static graph from_yaml(const YAML::Node& document, optional<builder> b = nullopt);
+    static graph from_yaml(const YAML::Node& document, const projection& proj, optional<builder> b = nullopt);
 
     friend YAML::Emitter& operator << (YAML::Emitter& lhs, const graph& rhs);
 #endif
@@ -0,0 +1,104 @@
+/**
+ * @file hrglib/graph_observer.hpp
+ * @brief Definition of `hrglib::graph_observer`, public subscription to graph mutations.
+ */
+#pragma once
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/pivot.hpp"
+
+#include <bitset>
+#include <cstddef>
+#include <vector>
+
+namespace hrglib {
+//! @brief Kind of graph mutation reported to `graph_observer`.
+enum struct mutation_kind {
+    node_created,
+    node_erasing,
+    //! @brief Any of `next`, `prev`, `parent`, `first_child` or `last_child` links.
+    link_changing,
+    //! @brief First or last node of a relation.
+    relation_changing,
+    //! @brief Feature set or removed.
+    feature_changing,
+    //! @brief "metadata" constant; number of defined kinds.
+    COUNT
+};
+
+//! @brief Set of `mutation_kind`s, indexed by their values.
+using mutation_kinds = std::bitset<static_cast<std::size_t>(mutation_kind::COUNT)>;
+
+//! @brief Description of single graph mutation.
+struct mutation_event {
+    mutation_kind kind;
+    //! @brief Node created, erased or changed; `nullptr` for `relation_changing`.
+    node* target = nullptr;
+    //! @brief Relation whose ends change, for `relation_changing`.
+    relation* rel = nullptr;
+    //! @brief Link changing, for `link_changing`.
+    pivot link = pivot::COUNT;
+    //! @brief Feature changing, for `feature_changing`.
+    feature_name feature = feature_name::COUNT;
+};
+
+/**
+ * @brief Base of user-defined observers of graph mutations, eg. for invalidating caches.
+ *
+ * Subscribes in the constructor and unsubscribes in the destructor. Graphs without observers
+ * or other listeners pay just a single emptiness check per mutation. Events are reported
+ * *before* the change takes place, except `node_created`, and only if their kind is among
+ * the ones given on construction.
+ *
+ * Batching observers get the events buffered, through `on_batch()`, once `batch_size`
+ * of them is collected or `flush()` is called. Nodes of `node_erasing` events may no longer
+ * exist by then and the events show only that the change happened, not the old state.
+ * Events still buffered can't reach `on_batch()` of a derived class once its destructor has
+ * run, so the destructor of `graph_observer` discards them; batching observers wanting to
+ * see every event have to call `flush()` in their own destructor.
+ */
+class graph_observer: private detail::mutation_listener {
+    hrglib::graph& graph_;
+    const mutation_kinds kinds_;
+    const std::size_t batch_size_;
+    std::vector<mutation_event> pending_;
+
+    void dispatch_(const mutation_event& e);
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+    void relation_changing(relation& r) override;
+    void feature_changing(node& n, feature_name feat) override;
+
+protected:
+    /**
+     * @brief Subscribe to mutations of @p g, which must outlive the observer.
+     * @param kinds kinds of events to report, all by default.
+     * @param batch_size number of events to buffer before reporting them together;
+     *     `0` reports each one right away.
+     */
+    explicit graph_observer(hrglib::graph& g, mutation_kinds kinds = mutation_kinds{}.set(),
+            std::size_t batch_size = 0);
+
+    //! @brief Receives single event, by default for each event of the batch too.
+    virtual void on_mutation(const mutation_event& e) { (void) e; }
+    //! @brief Receives buffered events of batching observer, in order of occurrence.
+    virtual void on_batch(const std::vector<mutation_event>& events);
+
+public:
+    graph_observer(const graph_observer&) = delete;
+    graph_observer& operator=(const graph_observer&) = delete;
+    //! @brief Unsubscribe, discarding the events not flushed yet.
+    ~graph_observer() override;
+
+    hrglib::graph& graph() noexcept { return graph_; }
+    const hrglib::graph& graph() const noexcept { return graph_; }
+    const mutation_kinds& kinds() const noexcept { return kinds_; }
+    std::size_t batch_size() const noexcept { return batch_size_; }
+    //! @brief Number of buffered events not reported yet.
+    std::size_t pending() const noexcept { return pending_.size(); }
+    //! @brief Report the buffered events, if any.
+    void flush();
+};
+}  // namespace hrglib
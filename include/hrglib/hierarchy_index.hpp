@@ -0,0 +1,84 @@
+/**
+ * @file hrglib/hierarchy_index.hpp
+ * @brief Definition of `hrglib::hierarchy_index`, fast ancestor queries over parent links.
+ */
+#pragma once
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/side_table.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/iterator.hpp"
+#include "hrglib/pivot.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Index of the trees formed by `parent()` links of all the nodes of a graph, across
+ *     relations (eg. Phrase > Token > Word > Syllable) as well as within recursive ones
+ *     (SylStructure).
+ *
+ * Nodes are numbered in depth-first order, children visited in their `first_child()` to
+ * `last_child()` order, so each subtree is a contiguous interval and `is_ancestor()` is O(1);
+ * jump pointers to the 2^k-th ancestors give O(log n) `ancestor()` and `lca()`, and the
+ * leaves of each subtree form a contiguous range of the ordered leaves. The index is
+ * invalidated by any change of links or nodes and rebuilt in O(n log n) on next query.
+ */
+class hierarchy_index: private detail::mutation_listener {
+public:
+    using leaf_iterator = std::vector<const node*>::const_iterator;
+
+private:
+    static constexpr std::uint32_t none = ~std::uint32_t{0};
+
+    graph& graph_;
+    bool valid_ = false;
+    std::size_t rebuilds_ = 0;
+    //! @brief Position of each node in `nodes_`, per relation.
+    std::array<side_table<std::uint32_t>, static_cast<std::size_t>(relation_name::COUNT)> positions_;
+    //! @brief Nodes in depth-first order.
+    std::vector<const node*> nodes_;
+    std::vector<std::uint32_t> depths_;
+    //! @brief One past the last descendant of each node.
+    std::vector<std::uint32_t> ends_;
+    //! @brief `jumps_[k][i]` is the 2^k-th ancestor of node @c i, or `none`.
+    std::vector<std::vector<std::uint32_t>> jumps_;
+    std::vector<const node*> leaves_;
+    //! @brief Range of `leaves_` under each node.
+    std::vector<std::uint32_t> leaves_begin_;
+    std::vector<std::uint32_t> leaves_end_;
+
+    void rebuild_();
+    //! @throw error::bad_node if @p n is not part of any tree (ie. on parent cycle).
+    std::uint32_t position_(const node& n);
+    std::uint32_t ascend_(std::uint32_t i, std::uint32_t levels) const noexcept;
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+
+public:
+    //! @brief Attach index to @p g, which must outlive it.
+    explicit hierarchy_index(graph& g);
+    hierarchy_index(const hierarchy_index&) = delete;
+    hierarchy_index& operator=(const hierarchy_index&) = delete;
+    ~hierarchy_index() override;
+
+    //! @return number of `parent()` links from @p n to its root.
+    std::size_t depth(const node& n);
+    //! @return ancestor of @p n at depth @p d (root is at 0), @p n itself for its depth;
+    //!     empty if @p n is not that deep.
+    node::const_navigator ancestor(const node& n, std::size_t d);
+    //! @return `true` if @p a is @p n or one of its ancestors.
+    bool is_ancestor(const node& a, const node& n);
+    //! @return lowest common ancestor of @p a and @p b, empty if they are in different trees.
+    node::const_navigator lca(const node& a, const node& b);
+    //! @return leaves of the subtree of @p n in depth-first order.
+    iterator::range<leaf_iterator> leaves(const node& n);
+
+    //! @brief Number of times the index was built, for diagnostics.
+    std::size_t rebuilds() const noexcept { return rebuilds_; }
+};
+}  // namespace hrglib
@@ -0,0 +1,164 @@
+/**
+ * @file hrglib/journal.hpp
+ * @brief Definition of `hrglib::journal` mutation recorder and its counterpart `hrglib::replica`.
+ */
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/not_null.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/string.hpp"
+
+#ifdef HRGLIB_YAMLCPP_PUBLIC
+#include <yaml-cpp/node/node.h>
+#include <yaml-cpp/emitter.h>
+#endif
+
+#include <bitset>
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <iosfwd>
+
+namespace hrglib {
+namespace detail {
+struct delta;
+}
+
+//! @brief Encodings of the deltas written by `journal` and `stream_writer`.
+enum struct stream_format {
+    //! @brief Sequence of YAML documents, each terminated with `...` line.
+    yaml,
+    //! @brief One JSON object per line.
+    json,
+    //! @brief Compact length-prefixed binary chunks; readable only by library built with
+    //!     the same relation and feature lists.
+    binary,
+};
+
+/**
+ * @brief Records mutations of a `graph` so they can be written out as a compact delta
+ *     against a base snapshot.
+ *
+ * Obtained with `graph::start_journal()`. Every node handle gets a numeric id, stable for
+ * the lifetime of the journal; the base snapshot written with `snapshot()` and the deltas
+ * written with `flush()` refer to nodes by these ids. Repeated changes of the same link or
+ * feature are coalesced, so the size of a delta is proportional to what changed since the
+ * last flush, not to the size of the graph. Use `replica` to reconstruct the graph on the
+ * receiving side.
+ */
+class journal: private detail::mutation_listener {
+    friend hrglib::graph;
+
+    struct created_entry {
+        std::size_t id;
+        relation_name relation;
+        //! @brief Id of the node handle whose contents the created handle shares.
+        optional<std::size_t> shares;
+    };
+    struct features_entry {
+        //! @brief Any live handle of the contents owning the changed features.
+        const node* handle;
+        std::unordered_set<feature_name> changed;
+    };
+
+    //! @brief Recorded graph, updated when the graph is moved.
+    const hrglib::graph* graph_;
+    std::unordered_map<const node*, std::size_t> ids_;
+    std::size_t next_id_ = 0;
+
+    std::vector<created_entry> created_;
+    std::vector<std::size_t> erased_;
+    std::unordered_map<const node*, std::bitset<static_cast<std::size_t>(pivot::COUNT)>> links_;
+    std::unordered_map<const features*, features_entry> features_;
+    std::unordered_set<relation_name> relations_;
+
+    explicit journal(const hrglib::graph& g);
+    detail::delta collect_() const;
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+    void relation_changing(relation& r) override;
+    void feature_changing(node& n, feature_name feat) override;
+
+public:
+    journal(const journal&) = delete;
+    journal& operator=(const journal&) = delete;
+
+    //! @return `graph` whose mutations are recorded.
+    const hrglib::graph& graph() const noexcept { return *graph_; }
+
+    //! @return id of node handle @p n in snapshots and deltas.
+    //! @throw error::bad_node if @p n is not known to this journal.
+    std::size_t id(const node& n) const;
+
+    //! @return `true` if nothing was recorded since start or last flush.
+    bool empty() const noexcept;
+    //! @brief Forget the recorded mutations, making the current state the new base.
+    void clear() noexcept;
+
+    //! @brief Write the whole graph as YAML document with node ids used by this journal and
+    //!     start a new delta relative to it.
+    void snapshot(std::ostream& os);
+    //! @brief Write the mutations recorded since start or last flush as delta chunk
+    //!     and start a new one.
+    void flush(std::ostream& os, stream_format fmt = stream_format::yaml);
+
+#ifdef HRGLIB_YAMLCPP_PUBLIC
+    void snapshot(YAML::Emitter& out);
+    void flush(YAML::Emitter& out);
+#endif
+};
+
+/**
+ * @brief Reconstructs a `graph` from a base snapshot and a series of deltas written by `journal`
+ *     or `stream_writer`.
+ */
+class replica {
+    hrglib::graph graph_;
+    std::unordered_map<std::size_t, not_null<node*>> nodes_;
+
+    node& node_at(std::size_t id) const;
+    void apply_(const detail::delta& d);
+
+public:
+    //! @brief Start with an empty graph, eg. when all the nodes come with deltas.
+    explicit replica(optional<hrglib::graph::builder> b = nullopt);
+    //! @brief Start with base snapshot read from @p is.
+    //! @throw error::parsing_error if snapshot isn't valid graph with numeric node ids,
+    //!     as written by `journal::snapshot()`.
+    explicit replica(std::istream& is, optional<hrglib::graph::builder> b = nullopt);
+#ifdef HRGLIB_YAMLCPP_PUBLIC
+    explicit replica(const YAML::Node& snapshot, optional<hrglib::graph::builder> b = nullopt);
+#endif
+
+    //! @brief Apply all the delta chunks read from @p is, in order.
+    //! @throw error::parsing_error if delta is malformed or refers to unknown nodes.
+    replica& apply(std::istream& is, stream_format fmt = stream_format::yaml);
+    //! @brief Apply YAML delta documents contained in @p yaml.
+    replica& apply(string_view yaml);
+    /**
+     * @brief Apply single delta chunk read from @p is, for progressive reconstruction of
+     *     the graph while it is being streamed.
+     *
+     * YAML chunks must be terminated with `...` line, as written by `journal::flush()`
+     * and `stream_writer`.
+     *
+     * @return `false` if there was no more chunks in @p is.
+     * @throw error::parsing_error if delta is malformed or refers to unknown nodes.
+     */
+    bool apply_next(std::istream& is, stream_format fmt = stream_format::yaml);
+#ifdef HRGLIB_YAMLCPP_PUBLIC
+    //! @brief Apply a single delta document.
+    replica& apply(const YAML::Node& delta);
+#endif
+
+    const hrglib::graph& graph() const noexcept { return graph_; }
+    hrglib::graph& graph() noexcept { return graph_; }
+};
+}  // namespace hrglib
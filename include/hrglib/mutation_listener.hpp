@@ -0,0 +1,30 @@
+/**
+ * @file hrglib/mutation_listener.hpp
+ * @brief Definition of `hrglib::detail::mutation_listener` interface.
+ */
+#pragma once
+#include "hrglib/types.hpp"
+#include "hrglib/pivot.hpp"
+
+namespace hrglib::detail {
+/**
+ * @brief Receives notifications about mutations of the `graph` it is installed in.
+ *
+ * Notifications about changes are delivered *before* the change takes place, so the
+ * listener may still inspect the old state; creation is reported after the fact.
+ * Graphs without listeners don't pay anything beyond a single emptiness check per mutation.
+ */
+struct mutation_listener {
+    virtual ~mutation_listener() = default;
+    //! @brief Node handle @p n was just created and attached to its contents.
+    virtual void node_created(node& n) { (void) n; }
+    //! @brief Node handle @p n is about to be erased from its relation.
+    virtual void node_erasing(node& n) { (void) n; }
+    //! @brief Link @p p of node @p n is about to be changed.
+    virtual void link_changing(node& n, pivot p) { (void) n; (void) p; }
+    //! @brief First or last node of relation @p r is about to be changed.
+    virtual void relation_changing(relation& r) { (void) r; }
+    //! @brief Feature @p feat of (contents of) node @p n is about to be written or removed.
+    virtual void feature_changing(node& n, feature_name feat) { (void) n; (void) feat; }
+};
+}  // namespace hrglib::detail
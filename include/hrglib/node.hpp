@@ -4,12 +4,14 @@
  */
 #pragma once
 #include "hrglib/node_navigator.hpp"
+#include "hrglib/pivot.hpp"
 #include "hrglib/relation_name.hpp"
 #include "hrglib/relation_traits.hpp"
 #include "hrglib/relation_iterator.hpp"
 #include "hrglib/memory.hpp"
 #include "hrglib/type_traits.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <unordered_map>
 
@@ -22,14 +24,18 @@ class relation;
 //!    at runtime.
 class node {
     friend hrglib::relation;
+    friend detail::graph_access;
     using rel_t = hrglib::relation;
     using rel_name_t = hrglib::relation_name;
     //! @brief Represents shared node contents; contains the `features` and `node_map` instances.
     struct contents;
     //! @brief Holds the contents shared among `node` handles in different relations.
     contents& cont_;
-    //! @brief Backreference to `relation` this node belongs to.
-    rel_t& rel_;
+    //! @brief Backreference to `relation` this node belongs to; changes only when nodes
+    //!     move to other graph.
+    rel_t* rel_;
+    //! @brief Dense id within `rel_`, assigned by the relation on creation.
+    std::uint32_t id_ = 0;
     //! @brief Prev node in the same relation.
     node* prev_ = nullptr;
     //! @brief Next node in the same relation.
@@ -53,6 +59,11 @@ class node {
     contents& attach_contents(const rel_t& r, node* in_other_relation);
     void release_contents(const rel_t& r) noexcept;
 
+    //! @brief Field storing link @p p.
+    node*& link_(pivot p) noexcept;
+    //! @brief Set @p field of this node, which is link @p p, to @p n notifying graph listeners.
+    void write_(node*& field, pivot p, node* n);
+
     //! @brief Remove parent's references to this, via `first_child_` and `last_child_`.
     void unlink_parent();
     //! @brief Remove next's reference to this via `prev_`.
@@ -86,14 +97,25 @@ protected:
     //
     explicit node(rel_t& rel, node *in_other_relation = nullptr):
         cont_{attach_contents(rel, in_other_relation)},
-        rel_{rel}
+        rel_{&rel}
     {}
 
     node& set_next_(node* n);
     node& set_prev_(node* n);
+    //! @brief Unvalidated setters of the hierarchy links, used where the relations are known
+    //!     to fit already.
+    //! @{
     node& set_parent_(node* n);
     node& set_first_child_(node* n);
     node& set_last_child_(node* n);
+    //! @}
+    //! @brief Whether the graph uses the default validator, which accepts all the typed
+    //!     links, so that the typed setters may skip the validation.
+    bool typed_links_valid_() const noexcept;
+    //! @brief Set @p field, which is link @p p, to child @p c and make this its parent.
+    node& set_child_(node*& field, pivot p, node* c);
+    //! @brief Whether @p c may be child of this node, per the graph's relation validator.
+    bool allows_child_(const node& c) const;
     const std::function<bool(const rel_t& parent, const rel_t& child)>& relation_validator() const noexcept;
 
 public:
@@ -121,12 +143,18 @@ public:
     hrglib::features& features() noexcept;
 
     hrglib::relation_name relation_name() const noexcept;
-    constexpr const hrglib::relation& relation() const noexcept { return rel_; }
-    constexpr hrglib::relation& relation() noexcept { return rel_; }
+    constexpr const hrglib::relation& relation() const noexcept { return *rel_; }
+    constexpr hrglib::relation& relation() noexcept { return *rel_; }
 
     bool in(const hrglib::relation& r) const noexcept;
     bool in(hrglib::relation_name rel) const noexcept;
 
+    using id_type = std::uint32_t;
+    //! @brief Id of this node, unique among the live nodes of its relation and less than
+    //!     `relation::id_bound()`; ids of erased nodes are reused by the ones created later.
+    //! @see side_table
+    constexpr id_type id() const noexcept { return id_; }
+
     using const_navigator = node_navigator<const node>;
     using navigator = node_navigator<node>;
 
@@ -160,6 +188,10 @@ public:
     constexpr const_navigator nav() const noexcept { return {this}; }
     constexpr navigator nav() noexcept { return {this}; }
 
+    //! @brief Runtime-selected access to one of the links of this node.
+    const_navigator link(pivot p) const noexcept { return mutable_(*this).link(p); }
+    navigator link(pivot p) noexcept { return {link_(p)}; }
+
     constexpr const_navigator next() const noexcept { return {next_}; }
     constexpr navigator next() noexcept { return {next_}; }
     node& set_next(node* n);
@@ -238,8 +270,11 @@ public:
     constexpr parent_navigator parent() noexcept {
         return detail::static_node_cast<parent_type>(node::parent());
     }
+    //! @brief Set parent, validating it at runtime only if the graph has custom validator.
     NodeType& set_parent(parent_type* parent) {
-        return static_cast<NodeType&>(node::set_parent(parent));
+        static_assert(is_valid_link(parent_rel, NodeType::RELATION_NAME));
+        return static_cast<NodeType&>(
+                this->typed_links_valid_() ? node::set_parent_(parent) : node::set_parent(parent));
     }
     node& set_parent(node*) = delete;
 };
@@ -284,12 +319,19 @@ public:
     constexpr child_navigator last_child() noexcept {
         return detail::static_node_cast<child_type>(node::last_child());
     }
+    //! @brief Set children, validating them at runtime only if the graph has custom validator.
+    //! @{
     NodeType& set_first_child(child_type* child) {
-        return static_cast<NodeType&>(node::set_first_child(child));
+        static_assert(is_valid_link(NodeType::RELATION_NAME, child_rel));
+        return static_cast<NodeType&>(
+                this->typed_links_valid_() ? node::set_first_child_(child) : node::set_first_child(child));
     }
     NodeType& set_last_child(child_type* child) {
-        return static_cast<NodeType&>(node::set_last_child(child));
+        static_assert(is_valid_link(NodeType::RELATION_NAME, child_rel));
+        return static_cast<NodeType&>(
+                this->typed_links_valid_() ? node::set_last_child_(child) : node::set_last_child(child));
     }
+    //! @}
     node& set_first_child(node*) = delete;
     node& set_last_child(node*) = delete;
 };
@@ -312,6 +354,57 @@ public:
     node& set_first_child(node*) = delete;
     node& set_last_child(node*) = delete;
 };
+
+//! @brief Follow typed `parent()` links from @p n up to relation @p ancestor.
+//!     Recursion is resolved at compile time, leaving a single null check per level.
+template<relation_name ancestor, class NodeType>
+constexpr node_navigator<copy_const_t<NodeType, node_t<ancestor>>> ascend(NodeType* n) noexcept {
+    constexpr auto rel = std::remove_cv_t<NodeType>::RELATION_NAME;
+    if constexpr (rel == ancestor) {
+        return {n};
+    } else if constexpr (hierarchy_distance(rel, ancestor) > 0) {
+        if (auto p = n->parent().get()) {
+            return ascend<ancestor>(p);
+        }
+        return {};
+    } else {
+        return {};
+    }
+}
+
+//! @brief Narrow nonempty span [@p first, @p last] down the typed `first_child()`/`last_child()`
+//!     links to the nodes of relation @p descendant. Childless nodes at the span ends are skipped.
+template<relation_name descendant, class NodeType>
+relation_span<copy_const_t<NodeType, node_t<descendant>>> descend(NodeType* first, NodeType* last) {
+    constexpr auto rel = std::remove_cv_t<NodeType>::RELATION_NAME;
+    constexpr auto child = child_relation<rel>;
+    using result_iterator = relation_iterator<copy_const_t<NodeType, node_t<descendant>>>;
+    if constexpr (rel == descendant) {
+        result_iterator end{last};
+        return {result_iterator{first}, ++end};
+    } else if constexpr (child != R::INVALID
+            && hierarchy_distance(descendant, child) >= 0
+            && hierarchy_distance(descendant, child) < hierarchy_distance(descendant, rel)) {
+        while (first != last && !first->first_child()) {
+            if ((first = first->next().get()) == nullptr) {
+                return {result_iterator{nullptr}, result_iterator{nullptr}};
+            }
+        }
+        while (last != first && !last->last_child()) {
+            if ((last = last->prev().get()) == nullptr) {
+                return {result_iterator{nullptr}, result_iterator{nullptr}};
+            }
+        }
+        auto cf = first->first_child().get();
+        auto cl = last->last_child().get();
+        if (cf != nullptr && cl != nullptr) {
+            return descend<descendant>(cf, cl);
+        }
+        return {result_iterator{nullptr}, result_iterator{nullptr}};
+    } else {
+        return {result_iterator{nullptr}, result_iterator{nullptr}};
+    }
+}
 }  // namespace detail
 
 //! @brief Represents the node in specific, compile-time constant, relation identified by @p rel.
@@ -376,5 +469,36 @@ public:
     node_t& insert_prev(node* in_other_relation = nullptr) {
         return static_cast<node_t&>(node::insert_prev(in_other_relation));
     }
+
+    //! @brief Ancestor of this node in relation @p ancestor, eg. `s.up<R::Phrase>()` for syllable.
+    //!     The hops are resolved at compile time from `relation_traits`.
+    template<hrglib::relation_name ancestor>
+    constexpr node_navigator<const hrglib::node_t<ancestor>> up() const noexcept {
+        static_assert(hierarchy_distance(rel, ancestor) >= 0, "no parent path to ancestor relation");
+        return detail::ascend<ancestor>(static_cast<const node_t*>(this));
+    }
+    //! @copydoc up() const
+    template<hrglib::relation_name ancestor>
+    constexpr node_navigator<hrglib::node_t<ancestor>> up() noexcept {
+        static_assert(hierarchy_distance(rel, ancestor) >= 0, "no parent path to ancestor relation");
+        return detail::ascend<ancestor>(static_cast<node_t*>(this));
+    }
+
+    //! @brief All descendants of this node in relation @p descendant, in relation order,
+    //!     eg. `p.leaves<R::Syllable>()` for phrase. The hops are resolved at compile time
+    //!     from `relation_traits`.
+    template<hrglib::relation_name descendant>
+    relation_span<const hrglib::node_t<descendant>> leaves() const {
+        static_assert(hierarchy_distance(descendant, rel) >= 0, "no child path to descendant relation");
+        const auto self = static_cast<const node_t*>(this);
+        return detail::descend<descendant>(self, self);
+    }
+    //! @copydoc leaves() const
+    template<hrglib::relation_name descendant>
+    relation_span<hrglib::node_t<descendant>> leaves() {
+        static_assert(hierarchy_distance(descendant, rel) >= 0, "no child path to descendant relation");
+        const auto self = static_cast<node_t*>(this);
+        return detail::descend<descendant>(self, self);
+    }
 };
 }  // namespace hrglib
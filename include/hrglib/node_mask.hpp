@@ -0,0 +1,142 @@
+/**
+ * @file hrglib/node_mask.hpp
+ * @brief Definition of `hrglib::node_mask`, compact set of rows of a relation.
+ */
+#pragma once
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Fixed-size bitmask selecting nodes of a relation by their position in it.
+ *
+ * Produced by `predicate::evaluate()`; the set operators combine masks of the same size
+ * a word (64 nodes) at a time.
+ */
+class node_mask {
+public:
+    using word_type = std::uint64_t;
+    static constexpr std::size_t word_bits = 64;
+
+private:
+    std::vector<word_type> words_;
+    std::size_t size_ = 0;
+
+    //! @brief Clear the bits beyond `size()` in the last word.
+    void trim_() noexcept {
+        if (const auto tail = size_ % word_bits; tail != 0) {
+            words_.back() &= (word_type{1} << tail) - 1;
+        }
+    }
+
+public:
+    node_mask() = default;
+    explicit node_mask(std::size_t size, bool value = false):
+        words_((size + word_bits - 1) / word_bits, value ? ~word_type{0} : word_type{0}),
+        size_{size}
+    {
+        trim_();
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    const std::vector<word_type>& words() const noexcept { return words_; }
+    std::vector<word_type>& words() noexcept { return words_; }
+
+    bool test(std::size_t i) const noexcept { return (words_[i / word_bits] >> (i % word_bits)) & 1u; }
+    node_mask& set(std::size_t i, bool value = true) noexcept {
+        const auto bit = word_type{1} << (i % word_bits);
+        if (value) {
+            words_[i / word_bits] |= bit;
+        } else {
+            words_[i / word_bits] &= ~bit;
+        }
+        return *this;
+    }
+
+    //! @return number of selected nodes.
+    std::size_t count() const noexcept {
+        std::size_t res = 0;
+        for (auto w: words_) {
+            res += std::bitset<word_bits>{w}.count();
+        }
+        return res;
+    }
+    bool any() const noexcept {
+        return std::any_of(words_.begin(), words_.end(), [](word_type w) { return w != 0; });
+    }
+    bool none() const noexcept { return !any(); }
+
+    //! @brief Call @p visit with index of each selected node, in increasing order.
+    template<typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            for (auto bits = words_[w]; bits != 0; bits &= bits - 1) {
+                // lowest set bit position is the number of trailing zeros below it
+                visit(w * word_bits + std::bitset<word_bits>{(bits & (~bits + 1)) - 1}.count());
+            }
+        }
+    }
+
+    /**
+     * @return mask whose bit `i` is bit `i + offset` of this one, or unset if that is out of
+     *     range; eg. `m.shifted(1)` selects the nodes whose next node is selected by `m`.
+     */
+    node_mask shifted(std::ptrdiff_t offset) const {
+        node_mask res{size_};
+        for_each([&](std::size_t i) {
+            const auto j = static_cast<std::ptrdiff_t>(i) - offset;
+            if (j >= 0 && static_cast<std::size_t>(j) < size_) {
+                res.set(static_cast<std::size_t>(j));
+            }
+        });
+        return res;
+    }
+
+    //! @pre `other.size() == size()` for all the set operators.
+    node_mask& operator&=(const node_mask& other) noexcept {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            words_[w] &= other.words_[w];
+        }
+        return *this;
+    }
+    node_mask& operator|=(const node_mask& other) noexcept {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            words_[w] |= other.words_[w];
+        }
+        return *this;
+    }
+    node_mask& operator^=(const node_mask& other) noexcept {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            words_[w] ^= other.words_[w];
+        }
+        return *this;
+    }
+    //! @brief Remove nodes selected by @p other.
+    node_mask& operator-=(const node_mask& other) noexcept {
+        for (std::size_t w = 0; w < words_.size(); ++w) {
+            words_[w] &= ~other.words_[w];
+        }
+        return *this;
+    }
+    node_mask operator~() const {
+        auto res = *this;
+        for (auto& w: res.words_) {
+            w = ~w;
+        }
+        res.trim_();
+        return res;
+    }
+
+    friend node_mask operator&(node_mask lhs, const node_mask& rhs) noexcept { return lhs &= rhs; }
+    friend node_mask operator|(node_mask lhs, const node_mask& rhs) noexcept { return lhs |= rhs; }
+    friend node_mask operator^(node_mask lhs, const node_mask& rhs) noexcept { return lhs ^= rhs; }
+    friend node_mask operator-(node_mask lhs, const node_mask& rhs) noexcept { return lhs -= rhs; }
+    friend bool operator==(const node_mask& lhs, const node_mask& rhs) noexcept {
+        return lhs.size_ == rhs.size_ && lhs.words_ == rhs.words_;
+    }
+    friend bool operator!=(const node_mask& lhs, const node_mask& rhs) noexcept { return !(lhs == rhs); }
+};
+}  // namespace hrglib
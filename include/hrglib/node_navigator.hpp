@@ -55,6 +55,11 @@ public:
         HRGLIB_NODE_NAVIGATOR_EVAL(pos_->template as<OtherNodeType>());
     }
 
+    template<relation_name rel>
+    constexpr auto up() const noexcept -> decltype(pos_->template up<rel>()) {
+        HRGLIB_NODE_NAVIGATOR_EVAL(pos_->template up<rel>());
+    }
+
     template<typename Callable>
     constexpr auto apply(Callable&& call) const -> decltype(std::forward<Callable>(call)(*pos_)) {
         HRGLIB_NODE_NAVIGATOR_EVAL(std::forward<Callable>(call)(*pos_));
@@ -0,0 +1,80 @@
+/**
+ * @file hrglib/order_index.hpp
+ * @brief Definition of `hrglib::order_index`, order-maintenance labeling of a relation.
+ */
+#pragma once
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/side_table.hpp"
+#include "hrglib/pivot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Order-maintenance labels of the nodes of a relation, answering "does @c a come before
+ *     @c b" in O(1) instead of walking `next()` links.
+ *
+ * Each node in the relation's sequence carries a 64-bit label increasing along the sequence.
+ * The labels are kept up to date incrementally from the graph mutation notifications: nodes
+ * whose `next`/`prev` links changed are relabelled on the next query using the gap between
+ * their unchanged neighbours; if the gap is too narrow, a window of nodes around them is
+ * spread evenly, doubling it until it has enough room, so that each insertion costs
+ * amortized O(log n). Ranks are recomputed on the next `rank()` query by a walk starting
+ * from the earliest changed node, so edits near the end of the relation are cheap while
+ * an edit at its front still renumbers all of it.
+ *
+ * Queries about nodes which are not in the sequence reachable from `relation::first()`
+ * give unspecified results.
+ */
+class order_index: private detail::mutation_listener {
+public:
+    using key_type = std::uint64_t;
+
+private:
+    hrglib::relation& relation_;
+    side_table<key_type> labels_;
+    side_table<std::size_t> ranks_;
+    //! @brief Nodes whose labels may be inconsistent with their neighbours.
+    std::unordered_set<const node*> pending_;
+    //! @brief Whether ranks are up to date before `stale_from_`.
+    bool ranks_valid_ = false;
+    //! @brief Earliest node whose rank may be stale; null if it's none or all of them.
+    const node* stale_from_ = nullptr;
+    std::size_t relabels_ = 0;
+    std::size_t renumbered_ = 0;
+
+    //! @brief Spread labels of @p run evenly between the ones of @p lo and @p hi, if possible.
+    bool spread_(const std::vector<const node*>& run, const node* lo, const node* hi);
+    void relabel_(std::vector<const node*> run);
+    void flush_();
+    //! @brief Mark ranks stale from @p n on; everything if @p n is not in the sequence.
+    void stale_from_node_(const node* n);
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+
+public:
+    //! @brief Attach index of the nodes of @p rel to its graph, which must outlive it.
+    explicit order_index(hrglib::relation& rel);
+    order_index(const order_index&) = delete;
+    order_index& operator=(const order_index&) = delete;
+    ~order_index() override;
+
+    const hrglib::relation& relation() const noexcept { return relation_; }
+
+    //! @return label of @p n, usable as sort key of nodes of the relation.
+    key_type key(const node& n);
+    //! @return `true` if @p a comes before @p b in the relation.
+    bool precedes(const node& a, const node& b) { return key(a) < key(b); }
+    //! @return position of @p n in the relation, counted from zero.
+    std::size_t rank(const node& n);
+    //! @brief Number of windows relabelled because of missing room, for diagnostics.
+    std::size_t relabels() const noexcept { return relabels_; }
+    //! @brief Number of ranks recomputed, for diagnostics.
+    std::size_t renumbered() const noexcept { return renumbered_; }
+};
+}  // namespace hrglib
@@ -0,0 +1,86 @@
+/**
+ * @file hrglib/path.hpp
+ * @brief Definition of `hrglib::path`, compiled feature path expression.
+ */
+#pragma once
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/string.hpp"
+#include "hrglib/any.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Festival-style path expression addressing feature of a node reachable from
+ *     the one it is evaluated at, eg. `R:SylStructure.parent.parent.name` or `n.p.name`.
+ *
+ * Expression is a `.`-separated list of steps followed by a feature name. The steps are:
+ * * `n` or `next`, `p` or `prev`, `parent`, `daughter1` or `first_child`, `daughtern` or
+ *   `last_child` - follow the link;
+ * * `R:<relation>` - go to handle of the same contents in other relation, like `node::as()`.
+ *
+ * The expression is compiled once into a list of opcodes. Evaluation follows
+ * `node_navigator` semantics: missing link or relation anywhere along the path yields
+ * empty result. It does not allocate.
+ */
+class path {
+    //! @brief Opcodes below `pivot::COUNT` follow link, the rest select relation.
+    using op = std::uint8_t;
+    string expr_;
+    std::vector<op> ops_;
+    feature_name feature_;
+
+    path(string expr, std::vector<op> ops, feature_name feat) noexcept;
+
+    const node* walk_(const node* n) const noexcept;
+
+public:
+    /**
+     * @brief Compile @p expr.
+     * @throw error::invalid_path if @p expr is malformed or names unknown step,
+     *     relation or feature.
+     */
+    static path compile(string_view expr);
+    /**
+     * @brief Get compiled @p expr from process-wide cache, compiling it on first use.
+     *
+     * Safe to call from multiple threads.
+     *
+     * @return reference valid until the program ends.
+     * @throw error::invalid_path as `compile()`; failures aren't cached.
+     */
+    static const path& cached(string_view expr);
+
+    const string& expression() const noexcept { return expr_; }
+    //! @return feature the path ends with.
+    feature_name feature() const noexcept { return feature_; }
+    //! @return number of steps taken before reading the feature.
+    std::size_t size() const noexcept { return ops_.size(); }
+
+    //! @return node whose feature is addressed by the path, evaluated at @p n.
+    node::const_navigator target(const node& n) const noexcept { return {walk_(&n)}; }
+    //! @copydoc target(const node&) const
+    node::navigator target(node& n) const noexcept { return {const_cast<node*>(walk_(&n))}; }
+
+    //! @return raw value of the feature addressed by the path, evaluated at @p n.
+    optional<const any&> operator()(const node& n) const;
+
+    /**
+     * @brief Evaluate the path at each node of @p r, in relation order.
+     * @param out output iterator accepting `optional<const any&>`.
+     * @return @p out past the last written result.
+     */
+    template<class OutputIt>
+    OutputIt evaluate(const relation& r, OutputIt out) const {
+        for (auto&& n: r) {
+            *out++ = (*this)(n);
+        }
+        return out;
+    }
+};
+}  // namespace hrglib
@@ -0,0 +1,13 @@
+#pragma once
+#include "hrglib/node.hpp"
+#include "hrglib/token.hpp"
+
+namespace hrglib {
+
+class phrase: public node_<R::Phrase> {
+    using base = node_<R::Phrase>;
+    using base::base;
+    friend node::default_factory;
+};
+
+}
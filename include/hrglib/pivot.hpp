@@ -0,0 +1,28 @@
+/**
+ * @file hrglib/pivot.hpp
+ * @brief Definition of `hrglib::pivot` enum naming the links between nodes.
+ */
+#pragma once
+#include "hrglib/string.hpp"
+
+namespace hrglib {
+//! @brief Names the links a `node` keeps to its neighbours in the same relation
+//!     and to its parent and children in the hierarchy.
+enum struct pivot {
+    next,
+    prev,
+    parent,
+    first_child,
+    last_child,
+    //! @brief "metadata" constant for performing compile-time validity checks;
+    //!     number of defined pivots.
+    COUNT
+};
+
+//! @throw error::parsing_error if @p name is not a valid pivot name.
+template<>
+pivot from_string<pivot>(string_view name);
+
+string_view to_string_view(pivot p);
+inline string to_string(pivot p) { return string{to_string_view(p)}; }
+}  // namespace hrglib
@@ -0,0 +1,79 @@
+/**
+ * @file hrglib/predicate.hpp
+ * @brief Definition of `hrglib::predicate`, node filter evaluated over whole relation at once.
+ */
+#pragma once
+#include "hrglib/types.hpp"
+#include "hrglib/node_mask.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/string.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace hrglib {
+//! @brief Comparison of integral feature value in `predicate::compare()`.
+enum struct comparison {
+    equal,
+    not_equal,
+    less,
+    less_equal,
+    greater,
+    greater_equal,
+};
+
+/**
+ * @brief Immutable condition on nodes of a relation, eg.
+ *     `predicate::in(F::name, {"a", "the"}) && predicate::compare(F::start_pos, comparison::greater, 3)`.
+ *
+ * Unlike checking each node while iterating, `evaluate()` works column by column: values of
+ * each feature mentioned are gathered into contiguous array once, tight comparison loops
+ * run over them and the partial results are combined as `node_mask` words. Nodes missing
+ * the feature never match comparisons. Predicates are cheap to copy and share terms.
+ */
+class predicate {
+public:
+    struct term;
+
+private:
+    std::shared_ptr<const term> term_;
+
+    explicit predicate(std::shared_ptr<const term> t) noexcept: term_{std::move(t)} {}
+
+public:
+    //! @brief Predicate matching all nodes.
+    predicate();
+
+    //! @brief Nodes having @p feat set.
+    static predicate has(feature_name feat);
+    /**
+     * @brief Nodes whose value of @p feat compares as @p cmp to @p value.
+     * @throw std::invalid_argument if @p feat is not integral.
+     */
+    static predicate compare(feature_name feat, comparison cmp, std::uint64_t value);
+    //! @brief Nodes whose value of @p feat, in its textual form, is one of @p values.
+    static predicate in(feature_name feat, std::vector<string> values);
+    static predicate in(feature_name feat, std::initializer_list<string> values) {
+        return in(feat, std::vector<string>(values));
+    }
+    //! @brief Nodes whose next node in the relation satisfies @p p.
+    static predicate next(const predicate& p);
+    //! @brief Nodes whose previous node in the relation satisfies @p p.
+    static predicate prev(const predicate& p);
+
+    friend predicate operator&&(const predicate& lhs, const predicate& rhs);
+    friend predicate operator||(const predicate& lhs, const predicate& rhs);
+    friend predicate operator!(const predicate& p);
+
+    //! @return mask of nodes of @p rel satisfying this predicate, indexed by their position.
+    node_mask evaluate(const relation& rel) const;
+    //! @return mask of @p nodes satisfying this predicate; `next()` and `prev()` refer to
+    //!     neighbours within @p nodes.
+    node_mask evaluate(const std::vector<const node*>& nodes) const;
+    //! @return nodes of @p rel satisfying this predicate, in their order.
+    std::vector<const node*> select(const relation& rel) const;
+};
+}  // namespace hrglib
@@ -0,0 +1,80 @@
+/**
+ * @file hrglib/projection.hpp
+ * @brief Definition of `hrglib::projection` used for partial loading of graphs.
+ */
+#pragma once
+#include "hrglib/feature_name.hpp"
+#include "hrglib/relation_name.hpp"
+
+#include <bitset>
+#include <initializer_list>
+#include <cstddef>
+
+namespace hrglib {
+/**
+ * @brief Selects the subset of relations and features materialized by graph loaders.
+ *
+ * Default-constructed projection keeps everything. Once any relation (or feature) is
+ * explicitly kept, only the kept relations (or features) are loaded; node handles in
+ * dropped relations are never created and links pointing into them are cut.
+ */
+class projection {
+    std::bitset<static_cast<std::size_t>(relation_name::COUNT)> relations_;
+    std::bitset<static_cast<std::size_t>(feature_name::COUNT)> features_;
+    bool all_relations_ = true;
+    bool all_features_ = true;
+
+    template<typename Enum, std::size_t N>
+    static bool test_(const std::bitset<N>& bits, Enum e) noexcept {
+        const auto i = static_cast<std::size_t>(e);
+        return i < N && bits.test(i);
+    }
+
+public:
+    //! @brief Projection keeping all relations and all features.
+    projection() = default;
+    //! @brief Projection keeping only given relations and features.
+    //! @param rels relations to keep; empty list drops all relations.
+    //! @param feats features to keep; empty list drops all features.
+    projection(std::initializer_list<relation_name> rels, std::initializer_list<feature_name> feats):
+        all_relations_{false},
+        all_features_{false}
+    {
+        for (auto rel: rels) {
+            keep(rel);
+        }
+        for (auto feat: feats) {
+            keep(feat);
+        }
+    }
+
+    //! @brief Add @p rel to kept relations, switching off keep-all mode for relations.
+    projection& keep(relation_name rel) {
+        all_relations_ = false;
+        relations_.set(static_cast<std::size_t>(rel));
+        return *this;
+    }
+    //! @brief Add @p feat to kept features, switching off keep-all mode for features.
+    projection& keep(feature_name feat) {
+        all_features_ = false;
+        features_.set(static_cast<std::size_t>(feat));
+        return *this;
+    }
+    projection& keep_all_relations() noexcept {
+        all_relations_ = true;
+        return *this;
+    }
+    projection& keep_all_features() noexcept {
+        all_features_ = true;
+        return *this;
+    }
+
+    bool has(relation_name rel) const noexcept { return all_relations_ || test_(relations_, rel); }
+    bool has(feature_name feat) const noexcept { return all_features_ || test_(features_, feat); }
+
+    bool keeps_all_relations() const noexcept { return all_relations_; }
+    bool keeps_all_features() const noexcept { return all_features_; }
+    //! @return `true` if this projection does not drop anything.
+    bool is_identity() const noexcept { return all_relations_ && all_features_; }
+};
+}  // namespace hrglib
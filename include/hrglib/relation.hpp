@@ -8,23 +8,32 @@
 #include "hrglib/type_traits.hpp"
 #include "hrglib/memory.hpp"
 
-#ifdef HRGLIB_YAMLCPP_PUBLIC
-#include <yaml-cpp/emitter.h>
-#endif
-
 #include <unordered_set>
+#include <cstdint>
 #include <functional>
 #include <iterator>
+#include <utility>
+#include <vector>
 
 namespace hrglib {
 class graph;
 
 class relation: private std::unordered_set<unique_ptr<node>> {
     using base = std::unordered_set<unique_ptr<node>>;
-    hrglib::graph& graph_;
+    //! @brief Owning graph, updated when the graph is moved.
+    hrglib::graph* graph_;
     const relation_name name_;
     node* first_ = nullptr;
     node* last_ = nullptr;
+    //! @brief Ids of erased nodes, available for reuse.
+    std::vector<node::id_type> free_ids_;
+    node::id_type id_bound_ = 0;
+    //! @brief Incremented whenever the sequence of nodes may have changed.
+    std::uint64_t sequence_version_ = 0;
+    //! @brief Last node appended to open relation, valid while `sequence_version_` is
+    //!     still `tail_version_`.
+    node* tail_ = nullptr;
+    std::uint64_t tail_version_ = 0;
 
     template<typename Comparator = node::equal, class Relation>
     static constexpr relation_iterator<copy_const_t<Relation, node>, Comparator> end_(Relation& r) noexcept {
@@ -33,26 +42,37 @@ class relation: private std::unordered_set<unique_ptr<node>> {
                 : r.last_;
     }
 
-#ifdef HRGLIB_YAMLCPP_PUBLIC
-    friend YAML::Emitter& operator << (YAML::Emitter& out, const hrglib::graph& g);
-#endif
+    friend hrglib::node;
+    friend hrglib::graph;
+    friend detail::graph_access;
 
 protected:
     explicit relation(hrglib::graph& g, relation_name rel):
-        graph_{g},
+        graph_{&g},
         name_{rel}
     {}
 
     relation(relation&&) = default;
 
-    relation& set_first_(node* n) {
-        first_ = n;
-        return *this;
-    }
-    relation& set_last_(node* n) {
-        last_ = n;
-        return *this;
-    }
+    //! @brief Unchecked setters notifying `graph` listeners.
+    //! @{
+    relation& set_first_(node* n);
+    relation& set_last_(node* n);
+    //! @}
+
+    //! @brief Erase @p doomed nodes of the sequence, relinking the survivors around them.
+    std::size_t erase_batch_(std::vector<node*> doomed, bool other_relations);
+    //! @brief Move the children of run @p first .. @p last next to the ones of @p before
+    //!     and @p position, which will be around the run.
+    void splice_children_(node* before, node* position, node& first, node& last);
+    //! @brief Take over all the nodes of @p other without notifying about them; the nodes
+    //!     moved are added to @p moved, their sequence is left as it was until `join_()`.
+    void absorb_(relation& other, std::vector<node*>& moved);
+    //! @brief Append the sequence of @p other emptied by `absorb_()` to this one.
+    void join_(relation& other);
+
+    //! @brief Version of the sequence of nodes, for subclasses caching it.
+    constexpr std::uint64_t sequence_version() const noexcept { return sequence_version_; }
 
 public:
     virtual ~relation() = default;
@@ -73,8 +93,8 @@ public:
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
     using reverse_iterator = std::reverse_iterator<iterator>;
 
-    constexpr const hrglib::graph& graph() const noexcept { return graph_; }
-    constexpr hrglib::graph& graph() noexcept { return graph_; }
+    constexpr const hrglib::graph& graph() const noexcept { return *graph_; }
+    constexpr hrglib::graph& graph() noexcept { return *graph_; }
 
     constexpr relation_name name() const noexcept { return name_; }
     //! Relation is open when it is like SylSegment: only first node makes sense but not last.
@@ -96,12 +116,89 @@ public:
     constexpr const_iterator cend() const noexcept { return end(); }
     constexpr iterator end() noexcept { return end_(*this); }
 
+    /**
+     * @brief Erase @p n, unlinking it from its neighbours, parent and children.
+     *
+     * @warning Unlike the range `erase()` and `erase_if()`, this leaves a gap in the
+     *     sequence: the nodes before and after @p n are not linked to each other, so the
+     *     sequence walked from `first()` stops before the gap. Erase the range
+     *     `[n, n.next())` to keep the sequence joined.
+     */
     void erase(node& n);
+    /**
+     * @brief Erase nodes from @p first up to @p last, linking the node before the range
+     *     with @p last.
+     * @return number of nodes erased.
+     */
+    std::size_t erase(iterator first, iterator last);
+    /**
+     * @brief Erase all nodes of the sequence satisfying @p pred in one sweep, linking each
+     *     survivor with the next one.
+     * @param other_relations whether to erase also the handles of erased nodes' contents in
+     *     other relations, likewise relinking the survivors there.
+     * @return number of nodes erased from this relation.
+     */
+    template<typename Predicate>
+    std::size_t erase_if(Predicate&& pred, bool other_relations = false) {
+        std::vector<node*> doomed;
+        for (auto&& n: *this) {
+            if (pred(n)) {
+                doomed.push_back(&n);
+            }
+        }
+        return erase_batch_(std::move(doomed), other_relations);
+    }
+    /**
+     * @brief Move the nodes from @p first up to @p last before @p position, or to the end
+     *     if it is `nullptr`, relinking only the nodes around the run.
+     *
+     * Moved nodes keep their parent if all its children move along; the ones whose parent
+     * keeps other children behind are detached from it. When @p position is among children
+     * of some parent, or next to the children of a parent the run was detached from, the run
+     * is adopted by that parent, which requires none of its nodes to keep other parent.
+     * Apart from the walks over the detached or adopted nodes, the cost doesn't depend on
+     * the length of the run.
+     *
+     * Moving the children too places them after the last child of the node now before
+     * the run, or else before the first child of the one after it, or at the respective end
+     * of their relation if the run is moved to an end. Only the run itself is walked to find
+     * its first and last child. Nothing is changed, at any level, if the splice throws.
+     * @param children whether to move also the children of the run, recursively, next to
+     *     the children of the nodes now around it.
+     * @throw error::bad_relation if @p position, @p first or @p last is not in this relation.
+     * @throw std::invalid_argument if the run would end up among children of other parent,
+     *     or if moving children between two nodes without children.
+     * @pre @p last is reachable from @p first and @p position is not within the run.
+     */
+    void splice(node* position, node& first, node& last, bool children = false);
     using base::size;
+    //! @brief Upper bound of `node::id()` of the nodes in this relation, which is the size
+    //!     needed by flat arrays indexed by it.
+    constexpr std::size_t id_bound() const noexcept { return id_bound_; }
+
+    //! @brief Visit all the nodes owned by this relation, including the loose ones,
+    //!     in unspecified order.
+    template<typename Visitor>
+    void for_each_node(Visitor&& visit) const {
+        for (auto&& n: static_cast<const base&>(*this)) {
+            visit(std::as_const(*n));
+        }
+    }
+    //! @copydoc for_each_node() const
+    template<typename Visitor>
+    void for_each_node(Visitor&& visit) {
+        for (auto&& n: static_cast<base&>(*this)) {
+            visit(*n);
+        }
+    }
+
     //! Create a loose node in this relation.
     node& create(node* in_other_relation = nullptr);
     //! Create a node, appending it to the end of relation as new end.
     node& append(node* in_other_relation = nullptr);
+    //! @brief Append @p count new nodes at once, reserving room for them first.
+    //! @return the appended nodes.
+    relation_span<node> append_bulk(std::size_t count);
 
     node& prepend(node* in_other_relation = nullptr);
 };
@@ -181,7 +278,22 @@ public:
     node_t& prepend(node* in_other_relation = nullptr) {
         return static_cast<node_t&>(base::prepend(in_other_relation));
     }
+
+    relation_span<node_t> append_bulk(std::size_t count) {
+        auto res = base::append_bulk(count);
+        return {detail::static_node_cast<node_t>(res.begin()), detail::static_node_cast<node_t>(res.end())};
+    }
     void erase(node_t& n) { base::erase(n); }
     void erase(node&) = delete;
+    std::size_t erase(iterator first, iterator last) {
+        return base::erase(base::iterator{first.nav()}, base::iterator{last.nav()});
+    }
+    template<typename Predicate>
+    std::size_t erase_if(Predicate&& pred, bool other_relations = false) {
+        return base::erase_if([&](node& n) { return pred(static_cast<node_t&>(n)); }, other_relations);
+    }
+    void splice(node_t* position, node_t& first, node_t& last, bool children = false) {
+        base::splice(position, first, last, children);
+    }
 };
 }  // namespace hrglib
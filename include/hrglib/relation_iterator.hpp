@@ -102,4 +102,7 @@ template<class NodeType, typename Comparator = std::equal_to<node>>
 using relation_ahead = iterator::range_with_sentinel<relation_iterator<NodeType, Comparator>>;
 template<class NodeType, typename Comparator = std::equal_to<node>>
 using relation_before = iterator::reverse_range_with_sentinel<relation_iterator<NodeType, Comparator>>;
+//! @brief Contiguous, possibly empty, run of nodes of one relation.
+template<class NodeType, typename Comparator = std::equal_to<node>>
+using relation_span = iterator::range<relation_iterator<NodeType, Comparator>>;
 }  // namespace hrglib
@@ -8,6 +8,8 @@
 #include "hrglib/relation_name.hpp"
 #include "hrglib/relation_types.hpp"
 
+#include <cstddef>
+
 namespace hrglib {
 /**
  * @brief Defines compile-time properties of `relation` of type @p Rel.
@@ -74,4 +76,68 @@ using relation_t = typename relation_traits<rel>::relation_type;
     HRGLIB_RELATION_DEF(R:: rel, node_class, relation_class, R:: parent_rel, R:: child_rel);
 
 HRGLIB_RELATION_LIST(HRGLIB_RELATION_DEF_VISITOR)
+
+namespace detail {
+//! @brief `parent_relation` of each relation, indexable in constant expressions.
+inline constexpr relation_name parent_relations[] = {
+#define HRGLIB_PARENT_RELATION_ENTRY(rel, node_class, relation_class, parent_rel, ...) R:: parent_rel,
+    HRGLIB_RELATION_LIST(HRGLIB_PARENT_RELATION_ENTRY)
+#undef HRGLIB_PARENT_RELATION_ENTRY
+};
+
+//! @brief `child_relation` of each relation, indexable in constant expressions.
+inline constexpr relation_name child_relations[] = {
+#define HRGLIB_CHILD_RELATION_ENTRY(rel, node_class, relation_class, parent_rel, child_rel, ...) R:: child_rel,
+    HRGLIB_RELATION_LIST(HRGLIB_CHILD_RELATION_ENTRY)
+#undef HRGLIB_CHILD_RELATION_ENTRY
+};
+
+constexpr auto relation_count = static_cast<std::size_t>(R::COUNT);
+
+//! @brief Parent/child adjacency matrix of the relations, indexed by parent and child.
+struct link_table {
+    bool allowed[relation_count][relation_count];
+};
+
+constexpr link_table make_link_table() noexcept {
+    link_table res{};
+    for (std::size_t rel = 0; rel < relation_count; ++rel) {
+        if (const auto parent = parent_relations[rel]; parent != R::INVALID) {
+            res.allowed[static_cast<std::size_t>(parent)][rel] = true;
+        }
+        if (const auto child = child_relations[rel]; child != R::INVALID) {
+            res.allowed[rel][static_cast<std::size_t>(child)] = true;
+        }
+    }
+    return res;
+}
+
+inline constexpr link_table valid_links = make_link_table();
+}
+
+/**
+ * @brief Whether nodes of relation @p child may have parent in relation @p parent according
+ *     to `parent_relation` and `child_relation` of `relation_traits`; a single table lookup.
+ */
+constexpr bool is_valid_link(relation_name parent, relation_name child) noexcept {
+    return parent != R::INVALID && child != R::INVALID
+            && detail::valid_links.allowed[static_cast<std::size_t>(parent)][static_cast<std::size_t>(child)];
+}
+
+/**
+ * @brief Number of parent links separating relation @p lower from relation @p upper
+ *     in the schema defined by `relation_traits`.
+ * @return `0` if @p lower is @p upper, `-1` if @p upper is not above @p lower.
+ */
+constexpr int hierarchy_distance(relation_name lower, relation_name upper) noexcept {
+    int hops = 0;
+    for (auto rel = lower; rel != upper; ++hops) {
+        // recursive relations (eg. SylStructure) would loop forever
+        if (rel == R::INVALID || hops >= static_cast<int>(R::COUNT)) {
+            return -1;
+        }
+        rel = detail::parent_relations[static_cast<int>(rel)];
+    }
+    return hops;
+}
 }  // namespace hrglib
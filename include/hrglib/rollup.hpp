@@ -0,0 +1,107 @@
+/**
+ * @file hrglib/rollup.hpp
+ * @brief Definition of `hrglib::rollup`, incrementally maintained aggregate over hierarchy.
+ */
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/pivot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hrglib {
+//! @brief Aggregate operation computed by `rollup`.
+enum struct rollup_op {
+    //! @brief Number of descendants, regardless of their features.
+    count,
+    sum,
+    min,
+    max,
+};
+
+/**
+ * @brief Aggregate of integral feature over descendants in one relation of each node in
+ *     another, eg. sum of syllable durations per word or number of tokens per phrase.
+ *
+ * Descendants are the nodes whose chain of `parent()` links leads to the ancestor through
+ * the intermediate relations of `relation_traits` hierarchy. The aggregates are maintained
+ * incrementally from the graph mutation notifications: a changed descendant is retracted
+ * from its ancestor right away and added back on next read, so the reads are O(1) plus
+ * O(depth) for each descendant changed since the last read.
+ */
+class rollup: private detail::mutation_listener {
+public:
+    using value_type = std::uint64_t;
+
+private:
+    struct contribution {
+        //! @brief Intermediate nodes up to the ancestor, including it if reached.
+        std::vector<const node*> chain;
+        const node* ancestor = nullptr;
+        optional<value_type> value;
+    };
+    struct aggregate {
+        std::size_t count = 0;
+        value_type sum = 0;
+        //! @brief Values present, kept only for `min` and `max`.
+        std::multiset<value_type> values;
+    };
+
+    graph& graph_;
+    const rollup_op op_;
+    const relation_name ancestor_;
+    const relation_name descendant_;
+    const optional<feature_name> feature_;
+    const int depth_;
+
+    std::unordered_map<const node*, contribution> contributions_;
+    //! @brief Descendants reaching given intermediate or ancestor node.
+    std::unordered_map<const node*, std::unordered_set<const node*>> through_;
+    std::unordered_map<const node*, aggregate> aggregates_;
+    //! @brief Descendants to be added back on next read.
+    std::unordered_set<const node*> pending_;
+
+    void retract_(const node& d);
+    void retract_through_(const node& x);
+    void resolve_(const node& d);
+    void flush_();
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+    void feature_changing(node& n, feature_name feat) override;
+
+public:
+    /**
+     * @brief Attach rollup of @p feat over nodes of @p descendant under nodes of @p ancestor
+     *     to @p g, which must outlive it.
+     * @throw std::invalid_argument if @p ancestor isn't above @p descendant in the hierarchy,
+     *     or @p feat isn't given for operations other than `count`, or isn't integral.
+     */
+    rollup(graph& g, rollup_op op, relation_name ancestor, relation_name descendant,
+            optional<feature_name> feat = nullopt);
+    rollup(const rollup&) = delete;
+    rollup& operator=(const rollup&) = delete;
+    ~rollup() override;
+
+    rollup_op op() const noexcept { return op_; }
+    relation_name ancestor() const noexcept { return ancestor_; }
+    relation_name descendant() const noexcept { return descendant_; }
+    const optional<feature_name>& feature() const noexcept { return feature_; }
+
+    /**
+     * @return aggregate over descendants of @p n; `0` for `count` and `sum` without
+     *     descendants, empty for `min` and `max` if no descendant has the feature.
+     * @throw error::bad_relation if @p n is not in the ancestor relation.
+     */
+    optional<value_type> get(const node& n);
+};
+}  // namespace hrglib
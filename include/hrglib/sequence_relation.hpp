@@ -0,0 +1,108 @@
+/**
+ * @file hrglib/sequence_relation.hpp
+ * @brief Definition of `hrglib::sequence_relation_`, relation with random access to its nodes.
+ */
+#pragma once
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/relation_traits.hpp"
+#include "hrglib/iterator.hpp"
+#include "hrglib/memory.hpp"
+
+#include <boost/iterator/indirect_iterator.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Relation keeping a contiguous array of its nodes in sequence order next to the
+ *     links, for relations built left to right such as Token.
+ *
+ * `begin()`/`end()` are random-access iterators into the array, so the relation works
+ * with `std::lower_bound` and parallel algorithms, and
+ * `operator[]` is O(1). The array is extended in O(1) by `append()` through this class;
+ * any other change of the sequence (including `append()` through a plain `relation&`)
+ * only marks it stale and it is rebuilt by single walk on next access. As with
+ * `std::vector`, changing the sequence invalidates the iterators. `next()`/`prev()`
+ * navigation of the nodes is unaffected.
+ *
+ * Selected per relation with `sequence_relation_factory` when constructing the graph.
+ */
+template<relation_name rel>
+class sequence_relation_: public relation_<rel> {
+    using base = relation_<rel>;
+    using node_t = hrglib::node_t<rel>;
+
+    mutable std::vector<node_t*> index_;
+    mutable std::uint64_t indexed_version_ = std::numeric_limits<std::uint64_t>::max();
+
+    friend struct sequence_relation_factory;
+
+    const std::vector<node_t*>& sync_() const {
+        if (indexed_version_ != this->sequence_version()) {
+            index_.clear();
+            for (auto&& n: static_cast<const base&>(*this)) {
+                index_.push_back(&const_cast<node_t&>(n));
+            }
+            indexed_version_ = this->sequence_version();
+        }
+        return index_;
+    }
+
+protected:
+    explicit sequence_relation_(hrglib::graph& g):
+        base{g}
+    {}
+
+public:
+    using const_iterator = boost::indirect_iterator<typename std::vector<node_t*>::const_iterator, const node_t>;
+    using iterator = boost::indirect_iterator<typename std::vector<node_t*>::const_iterator, node_t>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    const_iterator begin() const { return const_iterator{sync_().cbegin()}; }
+    const_iterator cbegin() const { return begin(); }
+    iterator begin() { return iterator{sync_().cbegin()}; }
+
+    const_iterator end() const { return const_iterator{sync_().cend()}; }
+    const_iterator cend() const { return end(); }
+    iterator end() { return iterator{sync_().cend()}; }
+
+    //! @brief Number of nodes in the sequence, not counting the loose ones.
+    std::size_t length() const { return sync_().size(); }
+    const node_t& operator[](std::size_t i) const { return *sync_()[i]; }
+    node_t& operator[](std::size_t i) { return *sync_()[i]; }
+    //! @throw std::out_of_range if @p i is not less than `length()`.
+    const node_t& at(std::size_t i) const { return *sync_().at(i); }
+    node_t& at(std::size_t i) { return *sync_().at(i); }
+
+    node_t& append(node* in_other_relation = nullptr) {
+        const bool synced = indexed_version_ == this->sequence_version();
+        auto& res = base::append(in_other_relation);
+        if (synced) {
+            index_.push_back(&res);
+            indexed_version_ = this->sequence_version();
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief Relation factory creating `sequence_relation_` for the relations given and the
+ *     default relations otherwise; pass to `graph::builder::with_relation_factory()`.
+ */
+struct sequence_relation_factory {
+    std::vector<relation_name> sequences;
+
+    sequence_relation_factory(std::initializer_list<relation_name> rels):
+        sequences(rels)
+    {}
+
+    unique_ptr<relation> operator()(hrglib::graph& g, relation_name rel) const;
+};
+}  // namespace hrglib
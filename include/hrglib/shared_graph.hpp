@@ -0,0 +1,223 @@
+/**
+ * @file hrglib/shared_graph.hpp
+ * @brief Definition of `hrglib::shared_graph`, read-only graph image handed over between
+ *     processes in POSIX shared memory.
+ */
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/feature_traits.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/string.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace hrglib {
+namespace detail::shm {
+//! @brief Marks absent node reference.
+constexpr std::uint32_t none = UINT32_MAX;
+
+enum struct state: std::uint32_t {
+    //! @brief Image is being written or was revoked by publisher.
+    closed,
+    published,
+    acquired,
+};
+
+struct relation_entry {
+    std::uint32_t present;
+    std::uint32_t first;
+    std::uint32_t last;
+    std::uint32_t size;
+};
+
+struct node_entry {
+    std::uint32_t relation;
+    std::uint32_t links[static_cast<std::size_t>(pivot::COUNT)];
+    //! @brief Next handle in the ring of handles sharing contents with this one.
+    std::uint32_t same_contents;
+    std::uint32_t features_begin;
+    std::uint32_t features_end;
+};
+
+struct feature_entry {
+    std::uint32_t name;
+    //! @brief Length of string value, in `header::strings` blob.
+    std::uint32_t length;
+    //! @brief Integral value or offset of string value.
+    std::uint64_t value;
+};
+
+//! @brief Start of shared memory image; all references are indices or offsets relative
+//!     to it, so the image may be mapped at different address in each process.
+struct header {
+    char magic[8];
+    std::uint32_t version;
+    std::atomic<std::uint32_t> state;
+    std::uint64_t size;
+    std::uint32_t node_count;
+    std::uint32_t feature_count;
+    std::uint64_t nodes;
+    std::uint64_t features;
+    std::uint64_t strings;
+    relation_entry relations[static_cast<std::size_t>(relation_name::COUNT)];
+
+    const node_entry& node(std::uint32_t i) const noexcept {
+        return reinterpret_cast<const node_entry*>(reinterpret_cast<const char*>(this) + nodes)[i];
+    }
+    const feature_entry& feature(std::uint32_t i) const noexcept {
+        return reinterpret_cast<const feature_entry*>(reinterpret_cast<const char*>(this) + features)[i];
+    }
+    string_view string(const feature_entry& fe) const noexcept {
+        return {reinterpret_cast<const char*>(this) + strings + fe.value, fe.length};
+    }
+};
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+    "lock-free atomics are required for cross-process synchronization");
+}  // namespace detail::shm
+
+/**
+ * @brief Navigable handle of node stored in `shared_graph` image.
+ *
+ * Mirrors the navigation interface of `node`, with the absence of link signalled by
+ * empty optional. String features are accessed in place, without copying.
+ */
+class shared_node {
+    const detail::shm::header* img_;
+    std::uint32_t index_;
+
+    const detail::shm::node_entry& entry_() const noexcept { return img_->node(index_); }
+    optional<shared_node> at_(std::uint32_t i) const noexcept {
+        if (i == detail::shm::none) {
+            return nullopt;
+        }
+        return shared_node{img_, i};
+    }
+    const detail::shm::feature_entry* find_(feature_name feat) const noexcept {
+        const auto& e = entry_();
+        for (auto i = e.features_begin; i != e.features_end; ++i) {
+            if (img_->feature(i).name == static_cast<std::uint32_t>(feat)) {
+                return &img_->feature(i);
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    shared_node(const detail::shm::header* img, std::uint32_t index) noexcept:
+        img_{img},
+        index_{index}
+    {}
+
+    //! @return position of this node in the image, stable across processes.
+    std::uint32_t index() const noexcept { return index_; }
+    hrglib::relation_name relation_name() const noexcept {
+        return static_cast<hrglib::relation_name>(entry_().relation);
+    }
+
+    optional<shared_node> link(pivot p) const noexcept {
+        return at_(entry_().links[static_cast<std::size_t>(p)]);
+    }
+    optional<shared_node> next() const noexcept { return link(pivot::next); }
+    optional<shared_node> prev() const noexcept { return link(pivot::prev); }
+    optional<shared_node> parent() const noexcept { return link(pivot::parent); }
+    optional<shared_node> first_child() const noexcept { return link(pivot::first_child); }
+    optional<shared_node> last_child() const noexcept { return link(pivot::last_child); }
+    //! @return handle of the same contents in relation @p rel.
+    optional<shared_node> as(hrglib::relation_name rel) const noexcept {
+        for (auto i = entry_().same_contents; i != index_; i = img_->node(i).same_contents) {
+            if (img_->node(i).relation == static_cast<std::uint32_t>(rel)) {
+                return shared_node{img_, i};
+            }
+        }
+        return rel == relation_name() ? optional<shared_node>{*this} : nullopt;
+    }
+
+    bool has(feature_name feat) const noexcept { return find_(feat) != nullptr; }
+    /**
+     * @brief Access value of @p feat.
+     *
+     * @return `optional<string_view>` pointing into the image for string features and
+     *     `optional<feature_t<feat>>` for unsigned integral ones.
+     */
+    template<feature_name feat>
+    auto get() const noexcept {
+        using type = feature_t<feat>;
+        static_assert(std::is_same_v<type, string> || std::is_unsigned_v<type>,
+            "only string and unsigned integral features are shared");
+        const auto fe = find_(feat);
+        if constexpr (std::is_same_v<type, string>) {
+            return fe ? optional<string_view>{img_->string(*fe)} : nullopt;
+        } else {
+            return fe ? optional<type>{static_cast<type>(fe->value)} : nullopt;
+        }
+    }
+
+    friend bool operator==(const shared_node& l, const shared_node& r) noexcept {
+        return l.img_ == r.img_ && l.index_ == r.index_;
+    }
+    friend bool operator!=(const shared_node& l, const shared_node& r) noexcept { return !(l == r); }
+};
+
+/**
+ * @brief Immutable image of a `graph` in named POSIX shared memory segment, which another
+ *     process can map and navigate directly, without parsing.
+ *
+ * Handoff protocol: the producer creates the image with `publish()`; exactly one consumer
+ * takes it over with `acquire()`, which removes the segment name, so the memory is released
+ * once both processes drop their `shared_graph`. If the publisher drops its `shared_graph`
+ * before anybody acquired the image, the image is revoked and the segment removed.
+ * `acquire()` copies the image into private memory of the consumer and checks that all its
+ * indices and offsets stay within it, so that a publisher still holding the segment mapped
+ * writable can't invalidate the image after the check.
+ *
+ * Available on POSIX systems only; elsewhere the library is built without it.
+ */
+class shared_graph {
+    const detail::shm::header* img_ = nullptr;
+    std::size_t size_ = 0;
+    string name_;
+    bool publisher_ = false;
+
+    shared_graph(const detail::shm::header* img, std::size_t size, string name, bool publisher) noexcept;
+    void release_() noexcept;
+
+public:
+    shared_graph(shared_graph&& other) noexcept;
+    shared_graph& operator=(shared_graph&& other) noexcept;
+    ~shared_graph();
+
+    /**
+     * @brief Write image of @p g into new shared memory segment @p name.
+     * @param name POSIX shared memory object name, eg. `/utterance-1`.
+     * @throw std::system_error on failure to create the segment.
+     * @throw error::bad_handoff if @p g contains features other than strings or unsigned integers.
+     */
+    static shared_graph publish(const hrglib::graph& g, const string& name);
+    /**
+     * @brief Map image published under @p name and take ownership of it.
+     * @throw std::system_error if the segment doesn't exist or can't be mapped.
+     * @throw error::bad_handoff if image is malformed, or was already acquired or revoked.
+     */
+    static shared_graph acquire(const string& name);
+
+    const string& name() const noexcept { return name_; }
+    //! @return `true` if this is publisher's handle and the image was taken over by a consumer.
+    bool handed_off() const noexcept;
+    //! @return number of bytes of the image.
+    std::size_t size() const noexcept { return size_; }
+
+    bool has(relation_name rel) const noexcept;
+    std::size_t size(relation_name rel) const noexcept;
+    optional<shared_node> first(relation_name rel) const noexcept;
+    optional<shared_node> last(relation_name rel) const noexcept;
+
+    //! @brief Copy the image into a live graph.
+    hrglib::graph to_graph(optional<hrglib::graph::builder> b = nullopt) const;
+};
+}  // namespace hrglib
@@ -0,0 +1,73 @@
+/**
+ * @file hrglib/side_table.hpp
+ * @brief Definition of `hrglib::side_table`, flat array of per-node data.
+ */
+#pragma once
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Values of type @p T attached to the nodes of one relation, stored in a flat array
+ *     indexed by `node::id()` instead of a hash map keyed by node address.
+ *
+ * The table grows on demand when written. Nodes without a written value read as the
+ * table's default. Ids are reused after `relation::erase()`, so values of erased nodes
+ * should be `reset()` if nodes created later must not inherit them.
+ */
+template<typename T>
+class side_table {
+    std::vector<T> values_;
+    T default_;
+
+public:
+    using value_type = T;
+
+    explicit side_table(T default_value = T{}):
+        default_{std::move(default_value)}
+    {}
+    //! @brief Table with room for all the nodes of @p rel.
+    explicit side_table(const relation& rel, T default_value = T{}):
+        values_(rel.id_bound(), default_value),
+        default_{std::move(default_value)}
+    {}
+
+    //! @return value of @p n, growing the table if needed.
+    T& operator[](const node& n) {
+        if (n.id() >= values_.size()) {
+            values_.resize(n.id() + std::size_t{1}, default_);
+        }
+        return values_[n.id()];
+    }
+    //! @return value of @p n, or the default if none was written.
+    const T& operator[](const node& n) const noexcept {
+        return n.id() < values_.size() ? values_[n.id()] : default_;
+    }
+    //! @copydoc operator[](const node&) const
+    const T& get(const node& n) const noexcept { return (*this)[n]; }
+    side_table& set(const node& n, T value) {
+        (*this)[n] = std::move(value);
+        return *this;
+    }
+    //! @brief Restore default value of @p n.
+    void reset(const node& n) {
+        if (n.id() < values_.size()) {
+            values_[n.id()] = default_;
+        }
+    }
+
+    //! @brief Grow the table to hold all the nodes of @p rel.
+    void reserve(const relation& rel) {
+        if (rel.id_bound() > values_.size()) {
+            values_.resize(rel.id_bound(), default_);
+        }
+    }
+    std::size_t size() const noexcept { return values_.size(); }
+    const T& default_value() const noexcept { return default_; }
+    void clear() noexcept { values_.clear(); }
+};
+}  // namespace hrglib
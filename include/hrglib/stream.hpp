@@ -0,0 +1,81 @@
+/**
+ * @file hrglib/stream.hpp
+ * @brief Definition of `hrglib::stream_writer` emitting graph incrementally while it is being built.
+ */
+#pragma once
+#include "hrglib/journal.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/types.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <unordered_map>
+#include <utility>
+
+namespace hrglib {
+/**
+ * @brief Writes finalized prefixes of a `graph` under construction as a series of delta chunks,
+ *     readable progressively with `replica::apply_next()`.
+ *
+ * The producer promises not to modify nodes once they are finalized with `finalize()`, except
+ * for linking them to nodes added later (eg. `next` of the watermark or `last_child` of a final
+ * parent): their links, features and shared contents are written out right away and never
+ * revisited. Links to nodes which are not final yet are held back and written out together
+ * with their target.
+ * Each chunk is flushed to the output stream as soon as it's complete, so the time to first
+ * byte is bounded by the time needed to build the first finalized prefix, not the whole graph.
+ */
+class stream_writer {
+    struct chunk_;
+
+    const hrglib::graph& graph_;
+    std::ostream& os_;
+    const stream_format format_;
+    std::unordered_map<const node*, std::size_t> ids_;
+    //! @brief Id of handle which carried the given contents' features in the stream.
+    std::unordered_map<const features*, std::size_t> contents_;
+    //! @brief Links from written nodes to nodes not written yet, keyed by target.
+    std::unordered_multimap<const node*, std::pair<const node*, pivot>> pending_;
+    //! @brief Last written node of the `next` chain of each relation.
+    std::unordered_map<relation_name, const node*> cursors_;
+    bool closed_ = false;
+
+    void write_node_(chunk_& c, const node& n);
+    bool write_prefix_(chunk_& c, const node& watermark);
+    void write_rest_(chunk_& c, const relation& r);
+    void write_chunk_(chunk_& c, bool final);
+
+public:
+    //! @brief Writer of @p g chunks into @p os; nothing is written until first `finalize()`.
+    stream_writer(const hrglib::graph& g, std::ostream& os, stream_format fmt = stream_format::yaml);
+    stream_writer(const stream_writer&) = delete;
+    stream_writer& operator=(const stream_writer&) = delete;
+
+    /**
+     * @brief Mark nodes of `watermark.relation()` up to and including @p watermark as final
+     *     and write them out, together with the subtree under @p watermark.
+     *
+     * The subtree is finalized by recursively finalizing `last_child()` of each watermark in its
+     * own relation, so finalizing a phrase writes out its tokens, words and syllables as well.
+     * Finalizing node which was already written is no-op.
+     *
+     * @throw error::bad_node if @p watermark can't be reached from the last finalized node along
+     *     `next` links.
+     * @throw std::logic_error if the writer was closed.
+     */
+    stream_writer& finalize(const node& watermark);
+    /**
+     * @brief Write out all the remaining nodes, including loose ones, and final first/last
+     *     nodes of all the relations.
+     *
+     * @throw std::logic_error if the writer was already closed.
+     */
+    void close();
+
+    bool closed() const noexcept { return closed_; }
+    //! @return id of @p n in written chunks.
+    //! @throw error::bad_node if @p n was not written yet.
+    std::size_t id(const node& n) const;
+};
+}  // namespace hrglib
@@ -0,0 +1,88 @@
+/**
+ * @file hrglib/tensor_export.hpp
+ * @brief Definition of `hrglib::tensor_export`, batch export of relation features to numeric buffers.
+ */
+#pragma once
+#include "hrglib/types.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/relation_name.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hrglib {
+//! @brief Arrangement of exported values in the caller's buffer.
+enum struct tensor_layout {
+    //! @brief `out[row * columns() + column]`
+    row_major,
+    //! @brief `out[column * rows() + row]`
+    columnar,
+};
+
+/**
+ * @brief Dense numeric export of integral features of the nodes of a relation, eg. as
+ *     input matrix of acoustic model with one row per syllable.
+ *
+ * The rows are the nodes of the relation in their order, collected once on construction;
+ * the export must not outlive changes of the relation's sequence. Each row has the
+ * features of its node followed by the ones of its neighbours in the context window, so
+ * for context (1, 1) and features `a, b` the columns are `a[-1], b[-1], a, b, a[+1], b[+1]`.
+ * Missing features and neighbours beyond the relation ends get the caller's filler value.
+ */
+class tensor_export {
+    relation_name relation_;
+    std::vector<const node*> rows_;
+    std::vector<feature_name> features_;
+    std::size_t before_ = 0;
+    std::size_t after_ = 0;
+    tensor_layout layout_ = tensor_layout::row_major;
+
+    template<typename T>
+    void fill_(T* out, std::size_t size, T missing) const;
+
+public:
+    /**
+     * @brief Export of @p feats of the nodes of @p rel.
+     * @throw std::invalid_argument if any of @p feats is not integral.
+     */
+    tensor_export(const hrglib::relation& rel, std::vector<feature_name> feats);
+
+    //! @brief Add @p before preceding and @p after following nodes to each row.
+    tensor_export& context(std::size_t before, std::size_t after) noexcept {
+        before_ = before;
+        after_ = after;
+        return *this;
+    }
+    tensor_export& layout(tensor_layout l) noexcept {
+        layout_ = l;
+        return *this;
+    }
+
+    relation_name relation() const noexcept { return relation_; }
+    const std::vector<feature_name>& features() const noexcept { return features_; }
+    std::size_t rows() const noexcept { return rows_.size(); }
+    std::size_t columns() const noexcept { return features_.size() * (before_ + 1 + after_); }
+    //! @brief Number of values written by `fill()`.
+    std::size_t size() const noexcept { return rows() * columns(); }
+    //! @return column of feature @p feat of the node @p offset positions from the row's one.
+    //! @throw std::out_of_range if @p feat or @p offset are not exported.
+    std::size_t column(feature_name feat, std::ptrdiff_t offset = 0) const;
+
+    /**
+     * @brief Write the exported values into @p out of @p size elements.
+     * @throw std::invalid_argument if @p size is less than `size()`.
+     */
+    void fill(float* out, std::size_t size, float missing = 0) const;
+    //! @copydoc fill()
+    void fill(double* out, std::size_t size, double missing = 0) const;
+
+    /**
+     * @brief Write index of the @p ancestor of each row's node in its relation into @p out
+     *     of @p size elements, `-1` for the nodes without one.
+     * @throw std::invalid_argument if @p ancestor is not above the exported relation in
+     *     the hierarchy, or @p size is less than `rows()`.
+     */
+    void fill_ancestors(relation_name ancestor, std::int64_t* out, std::size_t size) const;
+};
+}  // namespace hrglib
@@ -1,6 +1,7 @@
 #pragma once
 #include "hrglib/node.hpp"
 #include "hrglib/word.hpp"
+#include "hrglib/phrase.hpp"
 
 namespace hrglib {
 
@@ -0,0 +1,102 @@
+/**
+ * @file hrglib/transaction.hpp
+ * @brief Definition of `hrglib::graph::transaction`, undo log of graph edits.
+ */
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/mutation_listener.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/any.hpp"
+
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace hrglib {
+/**
+ * @brief Scope recording undo log of the edits of a graph, eg. for trying a rewrite rule and
+ *     abandoning it if later checks fail.
+ *
+ * Records link writes, changes of relations' first and last nodes, node creation and erasure
+ * and feature writes from the graph mutation notifications. `rollback()`, also done by the
+ * destructor unless `commit()` was called, restores the state from before the transaction
+ * in time proportional to the number of edits; `commit()` just drops the log.
+ *
+ * Transactions may be nested as long as the inner one ends first; edits done by its rollback
+ * are recorded by the outer ones. Nodes erased within the transaction are recreated by
+ * rollback at new addresses and with new `node::id()`, see `restored()`.
+ */
+class graph::transaction: private detail::mutation_listener {
+    enum struct kind { link, ends, feature, created, erased };
+    struct entry {
+        kind what;
+        //! @brief Node changed, created or erased; for `feature` owner of the features.
+        node* handle;
+        //! @brief For `link` old target, for `ends` old first node.
+        node* target = nullptr;
+        //! @brief For `ends` old last node.
+        node* other = nullptr;
+        relation* rel = nullptr;
+        pivot link = pivot::COUNT;
+        feature_name feature = feature_name::COUNT;
+        //! @brief Index to `values_` for `feature`, to `erasures_` for `erased`.
+        std::size_t extra = 0;
+    };
+    //! @brief Everything needed to recreate erased node.
+    struct erasure {
+        std::array<node*, static_cast<std::size_t>(pivot::COUNT)> links;
+        //! @brief Links of other nodes pointing to the erased one.
+        std::vector<std::pair<node*, pivot>> back_links;
+        //! @brief Other handle of the contents or `nullptr` if the node was the last one.
+        node* sibling;
+        //! @brief Features of the contents if the node was its last handle.
+        std::vector<std::pair<feature_name, any>> features;
+        bool first;
+        bool last;
+    };
+
+    graph& graph_;
+    std::vector<entry> log_;
+    std::vector<optional<any>> values_;
+    std::vector<erasure> erasures_;
+    //! @brief Addresses of nodes erased within the transaction, not reused yet.
+    std::unordered_set<const node*> dead_;
+    std::unordered_map<const node*, node*> restored_;
+    bool active_ = true;
+
+    void finish_() noexcept;
+
+    void node_created(node& n) override;
+    void node_erasing(node& n) override;
+    void link_changing(node& n, pivot p) override;
+    void relation_changing(relation& r) override;
+    void feature_changing(node& n, feature_name feat) override;
+
+public:
+    //! @brief Start recording edits of @p g, which must outlive the transaction.
+    explicit transaction(graph& g);
+    transaction(const transaction&) = delete;
+    transaction& operator=(const transaction&) = delete;
+    //! @brief Roll back unless committed.
+    ~transaction() override;
+
+    //! @brief Keep the edits and stop recording.
+    void commit() noexcept;
+    //! @brief Undo the edits and stop recording; no-op if not active.
+    void rollback();
+
+    bool active() const noexcept { return active_; }
+    //! @brief Number of recorded edits.
+    std::size_t size() const noexcept { return log_.size(); }
+    /**
+     * @return node recreated by `rollback()` in place of the node at @p old erased within
+     *     the transaction, or @p old itself if no such node was recreated.
+     */
+    node* restored(const node* old) const noexcept;
+};
+}  // namespace hrglib
@@ -15,6 +15,8 @@ using std::size_t;
 enum struct relation_name;
 class relation;
 template<relation_name> class relation_;
+template<relation_name> class sequence_relation_;
+struct sequence_relation_factory;
 template<relation_name> struct relation_traits;
 template<class NodeType, typename Comparator> class relation_iterator;
 
@@ -27,4 +29,30 @@ template<relation_name> class node_;
 template<class NodeType> class node_navigator;
 
 class graph;
+class compressed_graph;
+class shared_graph;
+class shared_node;
+class path;
+class predicate;
+class node_mask;
+template<typename T> class side_table;
+class order_index;
+class hierarchy_index;
+struct relation_columns;
+class projection;
+class journal;
+class derived_features;
+class graph_observer;
+enum struct mutation_kind;
+struct mutation_event;
+class rollup;
+enum struct rollup_op;
+class tensor_export;
+enum struct tensor_layout;
+
+namespace detail {
+//! @brief Backdoor to graph internals used by library facilities built on top of it.
+struct graph_access;
+struct mutation_listener;
+}
 }  // namespace hrglib
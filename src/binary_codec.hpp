@@ -0,0 +1,111 @@
+#pragma once
+#include "hrglib/error.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/string.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hrglib::detail {
+//! @brief Appends LEB128 varints and length-prefixed strings to a byte buffer.
+class byte_writer {
+    string& buf_;
+
+public:
+    explicit byte_writer(string& buf) noexcept: buf_{buf} {}
+
+    byte_writer& put_byte(std::uint8_t b) {
+        buf_.push_back(static_cast<char>(b));
+        return *this;
+    }
+    byte_writer& put_uint(std::uint64_t val) {
+        while (val >= 0x80) {
+            put_byte(static_cast<std::uint8_t>(val | 0x80));
+            val >>= 7;
+        }
+        return put_byte(static_cast<std::uint8_t>(val));
+    }
+    //! @brief Zig-zag coded signed value, so that small magnitudes take few bytes.
+    byte_writer& put_int(std::int64_t val) {
+        return put_uint((static_cast<std::uint64_t>(val) << 1) ^ static_cast<std::uint64_t>(val >> 63));
+    }
+    //! @brief Optional index coded as 0 for none and `val + 1` otherwise.
+    byte_writer& put_opt(const optional<std::size_t>& val) {
+        return put_uint(val ? *val + 1 : 0);
+    }
+    byte_writer& put_string(string_view s) {
+        put_uint(s.size());
+        buf_.append(s.data(), s.size());
+        return *this;
+    }
+
+    std::size_t size() const noexcept { return buf_.size(); }
+};
+
+//! @brief Reads back what `byte_writer` wrote.
+//! @throw error::parsing_error when reading past the end of input or malformed varint.
+class byte_reader {
+    string_view buf_;
+    std::size_t pos_ = 0;
+
+public:
+    explicit byte_reader(string_view buf) noexcept: buf_{buf} {}
+
+    bool at_end() const noexcept { return pos_ == buf_.size(); }
+    std::size_t position() const noexcept { return pos_; }
+
+    std::uint8_t get_byte() {
+        if (pos_ >= buf_.size()) {
+            throw error::parsing_error{"unexpected end of binary data"};
+        }
+        return static_cast<std::uint8_t>(buf_[pos_++]);
+    }
+    std::uint64_t get_uint() {
+        std::uint64_t res = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const auto b = get_byte();
+            res |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return res;
+            }
+        }
+        throw error::parsing_error{"malformed varint in binary data"};
+    }
+    //! @brief Read element count, rejecting counts which can't fit in the remaining input.
+    std::size_t get_count() {
+        const auto val = get_uint();
+        if (val > buf_.size() - pos_) {
+            throw error::parsing_error{"element count exceeds binary data size"};
+        }
+        return static_cast<std::size_t>(val);
+    }
+    std::int64_t get_int() {
+        const auto val = get_uint();
+        return static_cast<std::int64_t>(val >> 1) ^ -static_cast<std::int64_t>(val & 1);
+    }
+    optional<std::size_t> get_opt() {
+        if (const auto val = get_uint(); val != 0) {
+            return static_cast<std::size_t>(val - 1);
+        }
+        return nullopt;
+    }
+    string_view get_string() {
+        const auto len = get_uint();
+        if (len > buf_.size() - pos_) {
+            throw error::parsing_error{"unexpected end of binary data"};
+        }
+        auto res = buf_.substr(pos_, len);
+        pos_ += len;
+        return res;
+    }
+    //! @brief Read enumerator coded as its index, checking it against `Enum::COUNT`.
+    template<typename Enum>
+    Enum get_enum() {
+        const auto val = get_uint();
+        if (val >= static_cast<std::uint64_t>(Enum::COUNT)) {
+            throw error::parsing_error{"enumerator out of range in binary data"};
+        }
+        return static_cast<Enum>(val);
+    }
+};
+}  // namespace hrglib::detail
@@ -0,0 +1,129 @@
+#include "hrglib/columnar_import.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+#include "hrglib/any.hpp"
+
+#include "feature_codec.hpp"
+#include "graph_access.hpp"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hrglib {
+namespace {
+//! Values of the text columns of one `relation_columns`, parsed ahead.
+using parsed_columns = std::vector<std::vector<any>>;
+
+//! Check all of @p columns and parse their text values before @p g is changed at all.
+std::vector<parsed_columns> check_columns(graph& g, const std::vector<relation_columns>& columns) {
+    std::unordered_map<relation_name, std::size_t> rows;
+    // rows of parent relations already given children, which must be consecutive
+    std::unordered_map<relation_name, std::vector<bool>> adopted;
+    std::vector<parsed_columns> parsed;
+    parsed.reserve(columns.size());
+    for (auto&& cols: columns) {
+        auto& r = g.at(cols.relation);
+        if (cols.parents != nullptr) {
+            const auto parent_rows = map_find(rows, cols.parent_relation);
+            if (!parent_rows) {
+                throw std::invalid_argument{"parent relation " + to_string(cols.parent_relation)
+                        + " of " + to_string(cols.relation) + " was not imported before it"};
+            }
+            if (!g.relation_validator()(g.at(cols.parent_relation), r)) {
+                throw error::bad_relation{cols.parent_relation};
+            }
+            auto& has_children = adopted[cols.parent_relation];
+            has_children.resize(*parent_rows, false);
+            std::int64_t prev = -1;
+            for (std::size_t i = 0; i < cols.rows; ++i) {
+                const auto row = cols.parents[i];
+                if (row >= 0 && row != prev) {
+                    if (static_cast<std::size_t>(row) >= *parent_rows) {
+                        throw std::out_of_range{"parent row " + std::to_string(row) + " of "
+                                + to_string(cols.relation) + " node " + std::to_string(i) + " out of range"};
+                    }
+                    if (has_children[static_cast<std::size_t>(row)]) {
+                        throw std::invalid_argument{"children of " + to_string(cols.parent_relation)
+                                + " row " + std::to_string(row) + " are not consecutive"};
+                    }
+                    has_children[static_cast<std::size_t>(row)] = true;
+                }
+                prev = row;
+            }
+        }
+        for (auto&& col: cols.integral) {
+            if (!detail::feature_is_integral(col.feature)) {
+                throw std::invalid_argument{"feature " + to_string(col.feature) + " is not integral"};
+            }
+        }
+        auto& values = parsed.emplace_back();
+        values.reserve(cols.text.size());
+        for (auto&& col: cols.text) {
+            auto& v = values.emplace_back();
+            v.reserve(cols.rows);
+            for (std::size_t i = 0; i < cols.rows; ++i) {
+                v.push_back(detail::parse_feature_value(col.feature, col.values[i]));
+            }
+        }
+        rows[cols.relation] += cols.rows;
+    }
+    return parsed;
+}
+}  // namespace
+
+void import_columns(graph& g, const std::vector<relation_columns>& columns) {
+    auto parsed = check_columns(g, columns);
+    std::unordered_map<relation_name, std::vector<node*>> imported;
+    for (std::size_t c = 0; c < columns.size(); ++c) {
+        const auto& cols = columns[c];
+        auto& rows = imported[cols.relation];
+        const auto first_row = rows.size();
+        rows.reserve(first_row + cols.rows);
+        for (auto& n: g.at(cols.relation).append_bulk(cols.rows)) {
+            rows.push_back(&n);
+        }
+        const auto nodes = rows.data() + first_row;
+
+        for (auto&& col: cols.integral) {
+            for (std::size_t i = 0; i < cols.rows; ++i) {
+                detail::graph_access::put_feature(nodes[i]->features(), col.feature,
+                        detail::feature_value_from_uint(col.feature, col.values[i]));
+            }
+        }
+        for (std::size_t t = 0; t < cols.text.size(); ++t) {
+            auto& values = parsed[c][t];
+            for (std::size_t i = 0; i < cols.rows; ++i) {
+                detail::graph_access::put_feature(nodes[i]->features(), cols.text[t].feature,
+                        std::move(values[i]));
+            }
+        }
+
+        if (cols.parents == nullptr) {
+            continue;
+        }
+        const auto& parents = imported.at(cols.parent_relation);
+        std::int64_t prev = -1;
+        for (std::size_t i = 0; i < cols.rows; ++i) {
+            const auto row = cols.parents[i];
+            if (row < 0) {
+                prev = row;
+                continue;
+            }
+            auto& parent = *parents[static_cast<std::size_t>(row)];
+            auto& child = *nodes[i];
+            if (row != prev) {
+                detail::graph_access::assign_link(parent, pivot::first_child, &child);
+            }
+            detail::graph_access::assign_link(parent, pivot::last_child, &child);
+            detail::graph_access::assign_link(child, pivot::parent, &parent);
+            prev = row;
+        }
+    }
+}
+}  // namespace hrglib
@@ -0,0 +1,219 @@
+#include "hrglib/compressed_graph.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+#include "hrglib/pivot.hpp"
+
+#include "binary_codec.hpp"
+#include "feature_codec.hpp"
+#include "feature_entry.hpp"
+#include "graph_access.hpp"
+
+#include <cstdint>
+#include <typeinfo>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+namespace hrglib {
+namespace {
+constexpr std::uint8_t format_version = 1;
+constexpr auto pivot_count = static_cast<std::size_t>(pivot::COUNT);
+
+//! Links are coded as difference of node numbers relative to the linking node.
+std::int64_t distance(std::size_t from, std::size_t to) {
+    return static_cast<std::int64_t>(to) - static_cast<std::int64_t>(from);
+}
+
+//! Collects the strings used as feature values, coding each by its first-use index.
+class string_table {
+    std::unordered_map<string, std::size_t> index_;
+    std::vector<const string*> strings_;
+
+public:
+    std::size_t intern(string s) {
+        auto [it, inserted] = index_.try_emplace(std::move(s), strings_.size());
+        if (inserted) {
+            strings_.push_back(&it->first);
+        }
+        return it->second;
+    }
+
+    void write(detail::byte_writer& w) const {
+        w.put_uint(strings_.size());
+        for (auto s: strings_) {
+            w.put_string(*s);
+        }
+    }
+};
+}  // namespace
+
+compressed_graph graph::compress() const {
+    // number nodes relation by relation, each in its next order followed by loose nodes
+    std::vector<const relation*> rels;
+    std::vector<const node*> nodes;
+    std::unordered_map<const node*, std::size_t> numbers;
+    std::vector<std::size_t> rel_sizes;
+    for_each_relation([&](const relation& r) {
+        const auto start = nodes.size();
+        auto add = [&](const node* n) {
+            if (numbers.emplace(n, nodes.size()).second) {
+                nodes.push_back(n);
+            }
+        };
+        for (auto n = r.first().get(); n != nullptr && numbers.count(n) == 0; n = n->next().get()) {
+            add(n);
+        }
+        r.for_each_node([&](const node& n) { add(&n); });
+        rels.push_back(&r);
+        rel_sizes.push_back(nodes.size() - start);
+    });
+
+    string body;
+    detail::byte_writer w{body};
+    string_table strings;
+    std::unordered_map<const features*, std::size_t> contents;
+    auto rel_pos = nodes.cbegin();
+    for (std::size_t ri = 0; ri < rels.size(); ++ri) {
+        const auto& r = *rels[ri];
+        w.put_uint(static_cast<std::size_t>(r.name())).put_uint(rel_sizes[ri]);
+        auto number_of = [&](const node* n) -> optional<std::size_t> {
+            return n != nullptr ? optional<std::size_t>{numbers.at(n)} : nullopt;
+        };
+        w.put_opt(number_of(r.first().get())).put_opt(number_of(r.last().get()));
+        for (auto end = rel_pos + rel_sizes[ri]; rel_pos != end; ++rel_pos) {
+            const auto& n = **rel_pos;
+            const auto self = numbers.at(&n);
+            std::uint8_t mask = 0;
+            for (std::size_t i = 0; i < pivot_count; ++i) {
+                if (n.link(static_cast<pivot>(i))) {
+                    mask |= 1u << i;
+                }
+            }
+            w.put_byte(mask);
+            for (std::size_t i = 0; i < pivot_count; ++i) {
+                if (auto target = n.link(static_cast<pivot>(i))) {
+                    w.put_int(distance(self, numbers.at(target.get())));
+                }
+            }
+            const auto& feats = n.features();
+            if (auto shared = map_find(contents, &feats)) {
+                w.put_uint(self - *shared);
+                continue;
+            }
+            contents.emplace(&feats, self);
+            w.put_uint(0).put_uint(feats.size());
+            for (auto&& kv: feats) {
+                w.put_uint(static_cast<std::size_t>(kv.first));
+                if (detail::feature_is_integral(kv.first)) {
+                    w.put_uint(detail::feature_value_to_uint(kv.first, kv.second));
+                } else {
+                    w.put_uint(strings.intern(detail::format_feature_value(kv.first, kv.second)));
+                }
+            }
+        }
+    }
+
+    string data;
+    detail::byte_writer header{data};
+    header.put_byte(format_version).put_uint(nodes.size()).put_uint(rels.size());
+    strings.write(header);
+    data += body;
+    data.shrink_to_fit();
+    return compressed_graph{std::move(data)};
+}
+
+graph compressed_graph::decompress(optional<graph::builder> b) const {
+    auto g = b.value_or(graph::builder{}).build();
+    detail::byte_reader r{data_};
+    if (r.get_byte() != format_version) {
+        throw error::parsing_error{"unsupported compressed graph version"};
+    }
+    std::vector<node*> nodes(r.get_count());
+    const auto rel_count = r.get_count();
+    std::vector<string> strings(r.get_count());
+    for (auto&& s: strings) {
+        s = r.get_string();
+    }
+    std::vector<std::pair<const std::type_info*, any>> values(strings.size());
+    auto node_at = [&](std::size_t i) -> node& {
+        if (i >= nodes.size() || nodes[i] == nullptr) {
+            throw error::parsing_error{"invalid node reference in compressed graph"};
+        }
+        return *nodes[i];
+    };
+    auto opt_node = [&](const optional<std::size_t>& i) {
+        return i ? &node_at(*i) : nullptr;
+    };
+    // links may point forward, so they are resolved after all the nodes are created
+    struct link {
+        std::size_t from;
+        pivot which;
+        std::int64_t dist;
+    };
+    std::vector<link> links;
+    links.reserve(nodes.size());
+    std::size_t next = 0;
+    for (std::size_t ri = 0; ri < rel_count; ++ri) {
+        auto& rel = g[r.get_enum<relation_name>()];
+        const auto count = r.get_count();
+        const auto first = r.get_opt();
+        const auto last = r.get_opt();
+        if (count > nodes.size() - next) {
+            throw error::parsing_error{"node count mismatch in compressed graph"};
+        }
+        for (auto end = next + count; next != end; ++next) {
+            const auto mask = r.get_byte();
+            for (std::size_t i = 0; i < pivot_count; ++i) {
+                if (mask & (1u << i)) {
+                    links.push_back({next, static_cast<pivot>(i), r.get_int()});
+                }
+            }
+            if (const auto shared = r.get_uint(); shared != 0) {
+                if (shared > next) {
+                    throw error::parsing_error{"invalid node reference in compressed graph"};
+                }
+                nodes[next] = &rel.create(&node_at(next - shared));
+                continue;
+            }
+            auto& n = rel.create();
+            nodes[next] = &n;
+            auto& feats = n.features();
+            for (auto fc = r.get_count(); fc > 0; --fc) {
+                const auto feat = r.get_enum<feature_name>();
+                const auto val = r.get_uint();
+                if (detail::feature_is_integral(feat)) {
+                    detail::graph_access::put_feature(feats, feat, detail::feature_value_from_uint(feat, val));
+                } else if (val < strings.size()) {
+                    // values are parsed once per string and value type, then copied
+                    auto& cached = values[val];
+                    const auto& type = detail::feature_entry::for_(feat).type;
+                    if (cached.first == nullptr || *cached.first != type) {
+                        cached = {&type, detail::parse_feature_value(feat, strings[val])};
+                    }
+                    detail::graph_access::put_feature(feats, feat, cached.second);
+                } else {
+                    throw error::parsing_error{"invalid string reference in compressed graph"};
+                }
+            }
+        }
+        // ends are set once the nodes exist; forward references only within relation
+        rel.set_first(opt_node(first));
+        rel.set_last(opt_node(last));
+    }
+    if (next != nodes.size() || !r.at_end()) {
+        throw error::parsing_error{"node count mismatch in compressed graph"};
+    }
+    for (auto&& l: links) {
+        const auto target = static_cast<std::int64_t>(l.from) + l.dist;
+        if (target < 0) {
+            throw error::parsing_error{"invalid node reference in compressed graph"};
+        }
+        detail::graph_access::assign_link(*nodes[l.from], l.which, &node_at(static_cast<std::size_t>(target)));
+    }
+    return g;
+}
+}  // namespace hrglib
@@ -0,0 +1,472 @@
+#include "yaml-cpp_config.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+
+#include "delta.hpp"
+#include "graph_access.hpp"
+#include "binary_codec.hpp"
+#include "feature_codec.hpp"
+#include "yaml-cpp.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <iostream>
+#include <sstream>
+
+namespace hrglib::detail {
+namespace {
+constexpr char binary_magic[] = {'h', 'r', 'g', 'd'};
+
+template<typename Id>
+void emit_ref(YAML::Emitter& out, const Id& id) {
+    if (id) {
+        out << *id;
+    } else {
+        out << YAML::Null;
+    }
+}
+
+optional<std::size_t> load_ref(const YAML::Node& node) {
+    if (node.IsNull()) {
+        return nullopt;
+    }
+    return node.as<std::size_t>();
+}
+
+void json_string(std::ostream& os, string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    os << '"';
+    for (char c: s) {
+        switch (c) {
+        case '"': os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\n': os << "\\n"; break;
+        case '\r': os << "\\r"; break;
+        case '\t': os << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                os << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+            } else {
+                os << c;
+            }
+        }
+    }
+    os << '"';
+}
+
+void json_ref(std::ostream& os, const optional<std::size_t>& id) {
+    if (id) {
+        os << *id;
+    } else {
+        os << "null";
+    }
+}
+
+//! Emit comma separated list of @p items, each written by @p write.
+template<typename Items, typename Writer>
+void json_list(std::ostream& os, char open, const Items& items, char close, Writer&& write) {
+    os << open;
+    bool first = true;
+    for (auto&& item: items) {
+        if (!first) {
+            os << ',';
+        }
+        first = false;
+        write(item);
+    }
+    os << close;
+}
+
+void write_json(std::ostream& os, const delta& d) {
+    os << "{\"delta\":{";
+    bool first = true;
+    auto key = [&](const char* k) {
+        if (!first) {
+            os << ',';
+        }
+        first = false;
+        os << '"' << k << "\":";
+    };
+    if (!d.created.empty()) {
+        key("created");
+        json_list(os, '[', d.created, ']', [&](const delta::creation& ce) {
+            os << "{\"id\":" << ce.id << ",\"relation\":";
+            json_string(os, to_string_view(ce.relation));
+            if (ce.shares) {
+                os << ",\"with\":" << *ce.shares;
+            }
+            os << '}';
+        });
+    }
+    if (!d.erased.empty()) {
+        key("erased");
+        json_list(os, '[', d.erased, ']', [&](std::size_t id) { os << id; });
+    }
+    if (!d.linked.empty()) {
+        key("links");
+        json_list(os, '[', d.linked, ']', [&](const delta::links_update& le) {
+            os << "{\"id\":" << le.id;
+            for (auto&& l: le.links) {
+                os << ",\"" << to_string_view(l.which) << "\":";
+                json_ref(os, l.target);
+            }
+            os << '}';
+        });
+    }
+    if (!d.updated.empty()) {
+        key("features");
+        json_list(os, '[', d.updated, ']', [&](const delta::features_update& fe) {
+            os << "{\"id\":" << fe.id;
+            if (!fe.set.empty()) {
+                os << ",\"set\":";
+                json_list(os, '{', fe.set, '}', [&](auto&& kv) {
+                    json_string(os, to_string(kv.first));
+                    os << ':';
+                    if (feature_is_integral(kv.first)) {
+                        os << feature_value_to_uint(kv.first, kv.second);
+                    } else {
+                        json_string(os, format_feature_value(kv.first, kv.second));
+                    }
+                });
+            }
+            if (!fe.removed.empty()) {
+                os << ",\"remove\":";
+                json_list(os, '[', fe.removed, ']', [&](feature_name feat) {
+                    json_string(os, to_string(feat));
+                });
+            }
+            os << '}';
+        });
+    }
+    if (!d.bounds.empty()) {
+        key("relations");
+        json_list(os, '{', d.bounds, '}', [&](const delta::relation_ends& re) {
+            json_string(os, to_string_view(re.relation));
+            os << ":{\"first\":";
+            json_ref(os, re.first);
+            os << ",\"last\":";
+            json_ref(os, re.last);
+            os << '}';
+        });
+    }
+    os << "}}\n";
+}
+
+void write_binary(std::ostream& os, const delta& d) {
+    string buf;
+    byte_writer w{buf};
+    w.put_uint(d.created.size());
+    for (auto&& ce: d.created) {
+        w.put_uint(ce.id).put_uint(static_cast<std::size_t>(ce.relation)).put_opt(ce.shares);
+    }
+    w.put_uint(d.erased.size());
+    for (auto id: d.erased) {
+        w.put_uint(id);
+    }
+    w.put_uint(d.linked.size());
+    for (auto&& le: d.linked) {
+        w.put_uint(le.id).put_uint(le.links.size());
+        for (auto&& l: le.links) {
+            w.put_uint(static_cast<std::size_t>(l.which)).put_opt(l.target);
+        }
+    }
+    w.put_uint(d.updated.size());
+    for (auto&& fe: d.updated) {
+        w.put_uint(fe.id).put_uint(fe.set.size());
+        for (auto&& kv: fe.set) {
+            w.put_uint(static_cast<std::size_t>(kv.first));
+            if (feature_is_integral(kv.first)) {
+                w.put_uint(feature_value_to_uint(kv.first, kv.second));
+            } else {
+                w.put_string(format_feature_value(kv.first, kv.second));
+            }
+        }
+        w.put_uint(fe.removed.size());
+        for (auto feat: fe.removed) {
+            w.put_uint(static_cast<std::size_t>(feat));
+        }
+    }
+    w.put_uint(d.bounds.size());
+    for (auto&& re: d.bounds) {
+        w.put_uint(static_cast<std::size_t>(re.relation)).put_opt(re.first).put_opt(re.last);
+    }
+
+    string frame;
+    byte_writer{frame}.put_uint(buf.size());
+    os.write(binary_magic, sizeof(binary_magic));
+    os.write(frame.data(), frame.size());
+    os.write(buf.data(), buf.size());
+}
+
+delta read_binary(string_view buf) {
+    byte_reader r{buf};
+    delta d;
+    d.created.resize(r.get_count());
+    for (auto&& ce: d.created) {
+        ce.id = r.get_uint();
+        ce.relation = r.get_enum<relation_name>();
+        ce.shares = r.get_opt();
+    }
+    d.erased.resize(r.get_count());
+    for (auto&& id: d.erased) {
+        id = r.get_uint();
+    }
+    d.linked.resize(r.get_count());
+    for (auto&& le: d.linked) {
+        le.id = r.get_uint();
+        le.links.resize(r.get_count());
+        for (auto&& l: le.links) {
+            l.which = r.get_enum<pivot>();
+            l.target = r.get_opt();
+        }
+    }
+    d.updated.resize(r.get_count());
+    for (auto&& fe: d.updated) {
+        fe.id = r.get_uint();
+        for (auto n = r.get_count(); n > 0; --n) {
+            const auto feat = r.get_enum<feature_name>();
+            if (feature_is_integral(feat)) {
+                graph_access::put_feature(fe.set, feat, feature_value_from_uint(feat, r.get_uint()));
+            } else {
+                graph_access::put_feature(fe.set, feat, parse_feature_value(feat, string{r.get_string()}));
+            }
+        }
+        fe.removed.resize(r.get_count());
+        for (auto&& feat: fe.removed) {
+            feat = r.get_enum<feature_name>();
+        }
+    }
+    d.bounds.resize(r.get_count());
+    for (auto&& re: d.bounds) {
+        re.relation = r.get_enum<relation_name>();
+        re.first = r.get_opt();
+        re.last = r.get_opt();
+    }
+    if (!r.at_end()) {
+        throw error::parsing_error{"trailing data in binary delta"};
+    }
+    return d;
+}
+
+//! Read varint directly from stream, returning `nullopt` on clean end of stream.
+optional<std::uint64_t> read_frame_size(std::istream& is) {
+    char magic[sizeof(binary_magic)];
+    if (!is.read(magic, sizeof(magic))) {
+        if (is.gcount() == 0) {
+            return nullopt;
+        }
+        throw error::parsing_error{"unexpected end of binary delta stream"};
+    }
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(binary_magic))) {
+        throw error::parsing_error{"binary delta chunk expected"};
+    }
+    std::uint64_t res = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        const auto c = is.get();
+        if (c == std::char_traits<char>::eof()) {
+            throw error::parsing_error{"unexpected end of binary delta stream"};
+        }
+        res |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            return res;
+        }
+    }
+    throw error::parsing_error{"malformed binary delta chunk size"};
+}
+}  // namespace
+
+void emit_delta(YAML::Emitter& out, const delta& d) {
+    out << YAML::BeginMap << YAML::Key << "delta" << YAML::Value << YAML::BeginMap;
+    if (!d.created.empty()) {
+        out << YAML::Key << "created" << YAML::Value << YAML::BeginSeq;
+        for (auto&& ce: d.created) {
+            out << YAML::Flow << YAML::BeginMap
+                << YAML::Key << "id" << YAML::Value << ce.id
+                << YAML::Key << "relation" << YAML::Value << to_string(ce.relation);
+            if (ce.shares) {
+                out << YAML::Key << "with" << YAML::Value << *ce.shares;
+            }
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+    }
+    if (!d.erased.empty()) {
+        out << YAML::Key << "erased" << YAML::Value << YAML::Flow << d.erased;
+    }
+    if (!d.linked.empty()) {
+        out << YAML::Key << "links" << YAML::Value << YAML::BeginSeq;
+        for (auto&& le: d.linked) {
+            out << YAML::Flow << YAML::BeginMap << YAML::Key << "id" << YAML::Value << le.id;
+            for (auto&& l: le.links) {
+                out << YAML::Key << to_string(l.which) << YAML::Value;
+                emit_ref(out, l.target);
+            }
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+    }
+    if (!d.updated.empty()) {
+        out << YAML::Key << "features" << YAML::Value << YAML::BeginSeq;
+        for (auto&& fe: d.updated) {
+            out << YAML::BeginMap << YAML::Key << "id" << YAML::Value << fe.id;
+            if (!fe.set.empty()) {
+                out << YAML::Key << "set" << YAML::Value << YAML::Flow << fe.set;
+            }
+            if (!fe.removed.empty()) {
+                out << YAML::Key << "remove" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+                for (auto feat: fe.removed) {
+                    out << to_string(feat);
+                }
+                out << YAML::EndSeq;
+            }
+            out << YAML::EndMap;
+        }
+        out << YAML::EndSeq;
+    }
+    if (!d.bounds.empty()) {
+        out << YAML::Key << "relations" << YAML::Value << YAML::BeginMap;
+        for (auto&& re: d.bounds) {
+            out << YAML::Key << to_string(re.relation) << YAML::Value << YAML::Flow << YAML::BeginMap;
+            out << YAML::Key << "first" << YAML::Value;
+            emit_ref(out, re.first);
+            out << YAML::Key << "last" << YAML::Value;
+            emit_ref(out, re.last);
+            out << YAML::EndMap;
+        }
+        out << YAML::EndMap;
+    }
+    out << YAML::EndMap << YAML::EndMap;
+}
+
+delta load_delta(const YAML::Node& doc, const graph& g) {
+    if (!doc.IsMap() || !doc["delta"] || !doc["delta"].IsMap()) {
+        throw error::parsing_error{"delta document expected"};
+    }
+    const auto& rnm = g.relation_name_mapper();
+    const auto& fnm = g.feature_name_mapper();
+    const auto node = doc["delta"];
+    delta d;
+    try {
+        if (auto created = node["created"]) {
+            for (auto&& ce: created) {
+                d.created.push_back({
+                    ce["id"].as<std::size_t>(),
+                    rnm(ce["relation"].as<string>()),
+                    ce["with"] ? optional<std::size_t>{ce["with"].as<std::size_t>()} : nullopt
+                });
+            }
+        }
+        if (auto erased = node["erased"]) {
+            for (auto&& e: erased) {
+                d.erased.push_back(e.as<std::size_t>());
+            }
+        }
+        if (auto links = node["links"]) {
+            for (auto&& le: links) {
+                auto& lu = d.linked.emplace_back();
+                lu.id = le["id"].as<std::size_t>();
+                for (auto&& kv: le) {
+                    const auto key = kv.first.as<string>();
+                    if ("id" != key) {
+                        lu.links.push_back({from_string<pivot>(key), load_ref(kv.second)});
+                    }
+                }
+            }
+        }
+        if (auto feats = node["features"]) {
+            for (auto&& fe: feats) {
+                auto& fu = d.updated.emplace_back();
+                fu.id = fe["id"].as<std::size_t>();
+                if (auto set = fe["set"]) {
+                    fu.set = features::from_yaml(set, fnm);
+                }
+                if (auto removed = fe["remove"]) {
+                    for (auto&& name: removed) {
+                        fu.removed.push_back(fnm(name.as<string>()));
+                    }
+                }
+            }
+        }
+        if (auto rels = node["relations"]) {
+            for (auto&& kv: rels) {
+                d.bounds.push_back({
+                    rnm(kv.first.as<string>()),
+                    load_ref(kv.second["first"]),
+                    load_ref(kv.second["last"])
+                });
+            }
+        }
+    } catch (const YAML::Exception& ex) {
+        throw error::parsing_error{ex.what()};
+    }
+    return d;
+}
+
+void write_delta(std::ostream& os, const delta& d, stream_format fmt) {
+    switch (fmt) {
+    case stream_format::yaml: {
+        YAML::Emitter out{os};
+        out << YAML::BeginDoc;
+        emit_delta(out, d);
+        os << "\n...\n";
+        break;
+    }
+    case stream_format::json:
+        write_json(os, d);
+        break;
+    case stream_format::binary:
+        write_binary(os, d);
+        break;
+    }
+    os.flush();
+}
+
+optional<delta> read_delta(std::istream& is, stream_format fmt, const graph& g) {
+    if (stream_format::binary == fmt) {
+        const auto size = read_frame_size(is);
+        if (!size) {
+            return nullopt;
+        }
+        string buf(*size, '\0');
+        if (!is.read(buf.data(), buf.size())) {
+            throw error::parsing_error{"unexpected end of binary delta stream"};
+        }
+        return read_binary(buf);
+    }
+    string chunk, line;
+    bool has_content = false;
+    while (std::getline(is, line)) {
+        if (stream_format::json == fmt) {
+            if (line.find_first_not_of(" \t\r") == string::npos) {
+                continue;
+            }
+            chunk = std::move(line);
+            has_content = true;
+            break;
+        }
+        if ("..." == line) {
+            if (has_content) {
+                break;
+            }
+            continue;
+        }
+        if (line.find_first_not_of(" \t\r") != string::npos && line != "---") {
+            has_content = true;
+        }
+        chunk += line;
+        chunk += '\n';
+    }
+    if (!has_content) {
+        return nullopt;
+    }
+    YAML::Node doc;
+    try {
+        doc = YAML::Load(chunk);
+    } catch (const YAML::Exception& ex) {
+        throw error::parsing_error{ex.what()};
+    }
+    return load_delta(doc, g);
+}
+}  // namespace hrglib::detail
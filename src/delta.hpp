@@ -0,0 +1,73 @@
+#pragma once
+#include "yaml-cpp_config.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/journal.hpp"
+#include "hrglib/optional.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/string.hpp"
+
+#include "yaml-cpp.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+namespace hrglib::detail {
+/**
+ * @brief Change set of a graph, as written by `journal` and `stream_writer` and read by `replica`.
+ *
+ * Nodes are referred to by numeric ids assigned by the writer. Links, features and relation ends
+ * are carried in their final state, so a delta may be applied without knowing what it replaces.
+ */
+struct delta {
+    struct creation {
+        std::size_t id;
+        relation_name relation;
+        //! @brief Id of the node handle whose contents the created handle shares.
+        optional<std::size_t> shares;
+    };
+    struct link {
+        pivot which;
+        optional<std::size_t> target;
+    };
+    struct links_update {
+        std::size_t id;
+        std::vector<link> links;
+    };
+    struct features_update {
+        std::size_t id;
+        hrglib::features set;
+        std::vector<feature_name> removed;
+    };
+    struct relation_ends {
+        relation_name relation;
+        optional<std::size_t> first;
+        optional<std::size_t> last;
+    };
+
+    std::vector<creation> created;
+    std::vector<std::size_t> erased;
+    std::vector<links_update> linked;
+    std::vector<features_update> updated;
+    std::vector<relation_ends> bounds;
+
+    bool empty() const noexcept {
+        return created.empty() && erased.empty() && linked.empty() && updated.empty() && bounds.empty();
+    }
+};
+
+//! @brief Write @p d as body of YAML document.
+void emit_delta(YAML::Emitter& out, const delta& d);
+//! @brief Read delta from YAML (or JSON) document @p doc.
+//! @throw error::parsing_error if @p doc is not a delta document.
+delta load_delta(const YAML::Node& doc, const graph& g);
+
+//! @brief Write @p d as self-delimiting chunk in format @p fmt and flush @p os.
+void write_delta(std::ostream& os, const delta& d, stream_format fmt);
+//! @brief Read next chunk written by `write_delta()`.
+//! @return `nullopt` at the end of @p is.
+optional<delta> read_delta(std::istream& is, stream_format fmt, const graph& g);
+}  // namespace hrglib::detail
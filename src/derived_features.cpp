@@ -0,0 +1,179 @@
+#include "hrglib/derived_features.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+
+#include "graph_access.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace hrglib {
+namespace {
+//! Slot of contents' `features` source for the set of relations the contents is in.
+constexpr auto membership_slot = static_cast<std::size_t>(feature_name::COUNT);
+}  // namespace
+
+derived_features::derived_features(graph& g):
+    graph_{g}
+{
+    detail::graph_access::add_listener(g, *this);
+}
+
+derived_features::~derived_features() {
+    detail::graph_access::remove_listener(graph_, *this);
+}
+
+const any& derived_features::get_(std::size_t function, const node& n) {
+    const entry_key key{function, &n};
+    auto& st = stats_.at(function);
+    if (auto it = values_.find(key); it != values_.end()) {
+        ++st.hits;
+        return it->second;
+    }
+    if (!computing_.insert(key).second) {
+        throw std::logic_error{"derived feature depends on itself"};
+    }
+    ++st.misses;
+    any val;
+    try {
+        reader r{*this, key};
+        val = functions_[function](n, r);
+    } catch (...) {
+        computing_.erase(key);
+        forget_(key);
+        throw;
+    }
+    computing_.erase(key);
+    return values_.insert_or_assign(key, std::move(val)).first->second;
+}
+
+std::size_t derived_features::dependencies() const noexcept {
+    std::size_t n = 0;
+    for (auto&& [key, sources]: sources_) {
+        n += sources.size();
+    }
+    return n;
+}
+
+void derived_features::depend_(source_key source, const entry_key& dependent) {
+    if (dependents_[source].insert(dependent).second) {
+        sources_[dependent].push_back(source);
+    }
+}
+
+void derived_features::forget_(const entry_key& key) {
+    auto it = sources_.find(key);
+    if (it == sources_.end()) {
+        return;
+    }
+    for (auto&& source: it->second) {
+        if (auto d = dependents_.find(source); d != dependents_.end()) {
+            d->second.erase(key);
+            if (d->second.empty()) {
+                dependents_.erase(d);
+            }
+        }
+    }
+    sources_.erase(it);
+}
+
+void derived_features::drop_(const entry_key& key) {
+    if (values_.erase(key) != 0) {
+        ++stats_[key.function].invalidations;
+        forget_(key);
+        invalidate_({key.handle, derived_slot(key.function)});
+    }
+}
+
+void derived_features::invalidate_(source_key source) {
+    auto it = dependents_.find(source);
+    if (it == dependents_.end()) {
+        return;
+    }
+    const auto deps = std::move(it->second);
+    dependents_.erase(it);
+    for (auto&& key: deps) {
+        drop_(key);
+    }
+}
+
+void derived_features::node_created(node& n) {
+    invalidate_({&n.features(), membership_slot});
+}
+
+void derived_features::node_erasing(node& n) {
+    invalidate_({&n.features(), membership_slot});
+    for (std::size_t p = 0; p < static_cast<std::size_t>(pivot::COUNT); ++p) {
+        invalidate_({&n, p});
+    }
+    // the address may be reused by a new node
+    for (std::size_t f = 0; f < functions_.size(); ++f) {
+        drop_({f, &n});
+        invalidate_({&n, derived_slot(f)});
+    }
+}
+
+void derived_features::link_changing(node& n, pivot p) {
+    invalidate_({&n, static_cast<std::size_t>(p)});
+}
+
+void derived_features::relation_changing(relation& r) {
+    invalidate_({&r, 0});
+}
+
+void derived_features::feature_changing(node& n, feature_name feat) {
+    invalidate_({&n.features(), static_cast<std::size_t>(feat)});
+}
+
+derived_features::statistics derived_features::stats() const noexcept {
+    statistics res;
+    for (auto&& st: stats_) {
+        res.hits += st.hits;
+        res.misses += st.misses;
+        res.invalidations += st.invalidations;
+    }
+    return res;
+}
+
+void derived_features::clear() noexcept {
+    values_.clear();
+    dependents_.clear();
+    sources_.clear();
+}
+
+node::const_navigator derived_features::reader::link(node::const_navigator n, pivot p) {
+    if (!n) {
+        return {};
+    }
+    cache_.depend_({n.get(), static_cast<std::size_t>(p)}, dependent_);
+    return n->link(p);
+}
+
+node::const_navigator derived_features::reader::as(node::const_navigator n, relation_name rel) {
+    if (!n) {
+        return {};
+    }
+    cache_.depend_({&n->features(), membership_slot}, dependent_);
+    return n->as(rel);
+}
+
+node::const_navigator derived_features::reader::first(const relation& r) {
+    cache_.depend_({&r, 0}, dependent_);
+    return r.first();
+}
+
+node::const_navigator derived_features::reader::last(const relation& r) {
+    cache_.depend_({&r, 0}, dependent_);
+    return r.last();
+}
+
+optional<const any&> derived_features::reader::get(node::const_navigator n, feature_name feat) {
+    if (!n) {
+        return {};
+    }
+    cache_.depend_({&n->features(), static_cast<std::size_t>(feat)}, dependent_);
+    return n->features().get(feat);
+}
+}  // namespace hrglib
@@ -9,6 +9,7 @@
 #endif
 
 #include <memory>
+#include <utility>
 #include <cstdlib>   // for free
 
 namespace hrglib::error {
@@ -41,4 +42,19 @@ string demangle(const std::type_info& type) {
         return {type.name()};
     }
 }
+
+namespace {
+string describe(const std::vector<string>& violations) {
+    string res = "graph validation failed with " + std::to_string(violations.size()) + " violation(s)";
+    for (auto&& v: violations) {
+        res += "\n  " + v;
+    }
+    return res;
+}
+}  // namespace
+
+invalid_graph::invalid_graph(std::vector<string> violations):
+    std::runtime_error{describe(violations)},
+    violations{std::move(violations)}
+{}
 }
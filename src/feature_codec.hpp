@@ -0,0 +1,21 @@
+#pragma once
+#include "hrglib/feature_name.hpp"
+#include "hrglib/any.hpp"
+#include "hrglib/string.hpp"
+
+#include <cstdint>
+
+namespace hrglib::detail {
+//! @brief Textual form of feature value @p val, as written by the YAML emitter.
+string format_feature_value(feature_name feat, const any& val);
+//! @brief Inverse of `format_feature_value()`.
+//! @throw error::invalid_feature_type if @p text is not valid value of @p feat.
+any parse_feature_value(feature_name feat, const string& text);
+
+//! @return `true` if values of @p feat are unsigned integers which may be coded as such.
+bool feature_is_integral(feature_name feat);
+//! @pre `feature_is_integral(feat)`
+std::uint64_t feature_value_to_uint(feature_name feat, const any& val);
+//! @pre `feature_is_integral(feat)`
+any feature_value_from_uint(feature_name feat, std::uint64_t val);
+}  // namespace hrglib::detail
@@ -2,8 +2,12 @@
 #include "hrglib/features.hpp"
 #include "hrglib/not_null.hpp"
 #include "hrglib/error.hpp"
+#include "hrglib/projection.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/mutation_listener.hpp"
 
 #include "feature_entry.hpp"
+#include "feature_codec.hpp"
 #include "yaml-cpp.hpp"
 #include "utils.hpp"
 
@@ -14,6 +18,9 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
 
 namespace hrglib {
 namespace {
@@ -65,8 +72,28 @@ struct formatter {
     }
 };
 
+//! Integral representation of unsigned feature values, used by compact binary codecs.
+//! Left empty for non-integral types, which are coded through their textual form.
+template<typename FeatureType, typename = void>
+struct integral_codec {
+    static constexpr std::nullptr_t encode = nullptr;
+    static constexpr std::nullptr_t decode = nullptr;
+};
+
+template<typename FeatureType>
+struct integral_codec<FeatureType, std::enable_if_t<std::is_unsigned<FeatureType>::value>> {
+    static std::uint64_t encode(const any& val) {
+        return any_cast<const FeatureType&>(val);
+    }
+    static any decode(std::uint64_t val) {
+        return {static_cast<FeatureType>(val)};
+    }
+};
+
 using feature_value_from_yaml_t = any (*)(feature_name, const YAML::Node& value);
 using feature_to_string_t = string(*)(feature_name, const any& val);
+using feature_to_uint_t = std::uint64_t (*)(const any& val);
+using feature_from_uint_t = any (*)(std::uint64_t val);
 
 using type_info_ref_t = std::reference_wrapper<const std::type_info>;
 struct type_info_hasher {
@@ -75,12 +102,17 @@ struct type_info_hasher {
     }
 };
 
+struct parser_map_value_t {
+    not_null<feature_value_from_yaml_t> first;
+    not_null<feature_to_string_t> second;
+    //! Both `nullptr` unless feature type is unsigned integral.
+    feature_to_uint_t to_uint;
+    feature_from_uint_t from_uint;
+};
+
 using parser_map_t = std::unordered_map<
         type_info_ref_t,
-        std::pair<
-            not_null<feature_value_from_yaml_t>,
-            not_null<feature_to_string_t>
-        >,
+        parser_map_value_t,
         type_info_hasher,
         std::equal_to<std::type_info>>;
 
@@ -89,24 +121,82 @@ using parser_map_entry_t = typename parser_map_t::value_type;
 #define PARSER_MAP_ENTRY(feat, type, comment) \
     parser_map_entry_t{ \
         {typeid(feature_t<F:: feat >)}, \
-        {&yaml_parser<feature_t<F:: feat >>::read, &formatter<feature_t<F:: feat >>::format} \
+        { \
+            &yaml_parser<feature_t<F:: feat >>::read, \
+            &formatter<feature_t<F:: feat >>::format, \
+            integral_codec<feature_t<F:: feat >>::encode, \
+            integral_codec<feature_t<F:: feat >>::decode \
+        } \
     },
 
 const parser_map_t parser_map = {
     HRGLIB_FEATURE_LIST(PARSER_MAP_ENTRY)
 };
 
-any feature_value_from_yaml(const YAML::Node& value, feature_name feat) {
+const parser_map_value_t& parser_for(feature_name feat) {
     if (auto pe = map_find(parser_map, detail::feature_entry::for_(feat).type)) {
-        return (pe->first)(feat, value);
-     } else {
+        return *pe;
+    } else {
         assert(!"parser map missing parser for feature label with valid feature entry");
         throw std::logic_error{"missing yaml parser for feature " + to_string(feat)};
     }
 }
+
+any feature_value_from_yaml(const YAML::Node& value, feature_name feat) {
+    return (parser_for(feat).first)(feat, value);
+}
 }  // namespace
 
+namespace detail {
+string format_feature_value(feature_name feat, const any& val) {
+    return (parser_for(feat).second)(feat, val);
+}
+
+any parse_feature_value(feature_name feat, const string& text) {
+    return feature_value_from_yaml(YAML::Node{text}, feat);
+}
+
+bool feature_is_integral(feature_name feat) {
+    return parser_for(feat).to_uint != nullptr;
+}
+
+std::uint64_t feature_value_to_uint(feature_name feat, const any& val) {
+    const auto& pe = parser_for(feat);
+    assert(pe.to_uint != nullptr);
+    return (pe.to_uint)(val);
+}
+
+any feature_value_from_uint(feature_name feat, std::uint64_t val) {
+    const auto& pe = parser_for(feat);
+    assert(pe.from_uint != nullptr);
+    return (pe.from_uint)(val);
+}
+}  // namespace detail
+
+void features::notify_changing_(feature_name feat) {
+    assert(owner_ != nullptr);
+    owner_->graph().notify_(&detail::mutation_listener::feature_changing, *owner_, feat);
+}
+
+void features::notify_changing_all_(const features* other) {
+    assert(owner_ != nullptr);
+    for (auto&& kv: static_cast<const base&>(*this)) {
+        notify_changing_(kv.first);
+    }
+    if (other != nullptr) {
+        for (auto&& kv: static_cast<const base&>(*other)) {
+            if (base::count(kv.first) == 0) {
+                notify_changing_(kv.first);
+            }
+        }
+    }
+}
+
 features features::from_yaml(const YAML::Node& object, const name_mapper_type& name_mapper) {
+    return features::from_yaml(object, projection{}, name_mapper);
+}
+
+features features::from_yaml(const YAML::Node& object, const projection& proj, const name_mapper_type& name_mapper) {
     if (!object.IsMap()) {
         throw error::parsing_error{"features YAML node is not object"};
     }
@@ -114,10 +204,14 @@ features features::from_yaml(const YAML::Node& object, const name_mapper_type& n
             ? name_mapper
             : DEFAULT_NAME_MAPPER;
     features res;
-    res.reserve(object.size());
+    if (proj.keeps_all_features()) {
+        res.reserve(object.size());
+    }
     for (auto&& prop: object) {
         const auto feat = nm(prop.first.as<string>());
-        res.emplace(feat, feature_value_from_yaml(prop.second, feat));
+        if (proj.has(feat)) {
+            res.emplace(feat, feature_value_from_yaml(prop.second, feat));
+        }
     }
     return res;
 }
@@ -138,13 +232,8 @@ features features::from_file(string_view path, const name_mapper_type& name_mapp
 YAML::Emitter& operator << (YAML::Emitter& out, const features& feats) {
     out << YAML::BeginMap;
     for (auto&& feat: feats) {
-        out << YAML::Key << to_string(feat.first);
-        if (auto pe = map_find(parser_map, detail::feature_entry::for_(feat.first).type)) {
-            out << YAML::Value << (pe->second)(feat.first, feat.second);
-        } else {
-            assert(!"parser map missing formatter for feature label with valid feature entry");
-            throw std::logic_error{"missing formatter for feature " + to_string(feat.first)};
-        }
+        out << YAML::Key << to_string(feat.first)
+            << YAML::Value << detail::format_feature_value(feat.first, feat.second);
     }
     return out << YAML::EndMap;
 }
@@ -1,14 +1,27 @@
 #include "yaml-cpp_config.hpp"
 #include "hrglib/graph.hpp"
+#include "hrglib/journal.hpp"
 #include "hrglib/not_null.hpp"
 #include "hrglib/error.hpp"
+#include "hrglib/pivot.hpp"
+#include "hrglib/side_table.hpp"
 
+#include "graph_access.hpp"
+#include "graph_yaml.hpp"
 #include "yaml-cpp.hpp"
 #include "utils.hpp"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
 #include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <typeinfo>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 namespace hrglib {
 relation& graph::at(relation_name rel) {
@@ -19,6 +32,282 @@ relation& graph::at(relation_name rel) {
     }
 }
 
+graph& graph::movable_(graph& g) {
+    for (auto l: g.listeners_) {
+        if (l != g.journal_.get()) {
+            throw std::invalid_argument{"can't move graph with mutation listeners attached"};
+        }
+    }
+    return g;
+}
+
+graph::graph(graph&& other):
+    base{std::move(static_cast<base&>(movable_(other)))},
+    node_factory_{other.node_factory_},
+    relation_validator_{other.relation_validator_},
+    default_relation_validator_{other.default_relation_validator_},
+    relation_factory_{other.relation_factory_},
+    relation_name_mapper_{other.relation_name_mapper_},
+    feature_name_mapper_{other.feature_name_mapper_},
+    deferred_validation_{other.deferred_validation_},
+    listeners_{std::move(other.listeners_)},
+    journal_{std::move(other.journal_)}
+{
+    other.base::clear();
+    other.listeners_.clear();
+    // the relations and the journal refer back to the graph
+    for (auto&& kv: static_cast<base&>(*this)) {
+        kv.second->graph_ = this;
+    }
+    if (journal_) {
+        journal_->graph_ = this;
+    }
+}
+
+void graph::journal_deleter::operator()(hrglib::journal* j) const noexcept {
+    delete j;
+}
+
+graph::~graph() {
+    // Relations have to go while the graph is still intact, as the nodes reach
+    // back to it when unlinking; nobody is interested in these changes though.
+    listeners_.clear();
+    base::clear();
+}
+
+graph::collect_stats graph::collect() {
+    // reached flags, per relation by node id
+    std::unordered_map<const relation*, side_table<std::uint8_t>> reached;
+    std::vector<node*> stack;
+    const auto reach = [&](node* n) {
+        if (n != nullptr) {
+            auto& flag = reached[&n->relation()][*n];
+            if (flag == 0) {
+                flag = 1;
+                stack.push_back(n);
+            }
+        }
+    };
+    for_each_relation([&](relation& r) {
+        reached[&r].reserve(r);
+        reach(r.first().get());
+        reach(r.last().get());
+    });
+    while (!stack.empty()) {
+        auto n = stack.back();
+        stack.pop_back();
+        for (std::size_t p = 0; p < static_cast<std::size_t>(pivot::COUNT); ++p) {
+            reach(n->link(static_cast<pivot>(p)).get());
+        }
+    }
+
+    collect_stats res;
+    std::vector<node*> doomed;
+    for_each_relation([&](relation& r) {
+        const auto& flags = reached.at(&r);
+        r.for_each_node([&](node& n) {
+            if (flags[n] == 0) {
+                doomed.push_back(&n);
+            }
+        });
+    });
+    std::unordered_set<const features*> kept;
+    for (auto n: doomed) {
+        for (auto&& kv: n->relations()) {
+            if (auto& h = kv.second.get(); std::as_const(reached.at(&h.relation()))[h] != 0) {
+                kept.insert(&n->features());
+            }
+        }
+    }
+    std::unordered_set<const features*> released;
+    for (auto n: doomed) {
+        if (kept.count(&n->features()) == 0) {
+            released.insert(&n->features());
+        }
+    }
+    for (auto n: doomed) {
+        n->relation().erase(*n);
+    }
+    res.nodes = doomed.size();
+    res.contents = released.size();
+    return res;
+}
+
+void graph::validate() const {
+    std::vector<string> violations;
+    const auto describe = [](const node& n) {
+        return to_string(n.relation_name()) + " node " + std::to_string(n.id());
+    };
+    const auto fits = [this](const node& parent, const node& child) {
+        return default_relation_validator_
+                ? is_valid_link(parent.relation_name(), child.relation_name())
+                : relation_validator_(parent.relation(), child.relation());
+    };
+    for_each_relation([&](const relation& r) {
+        for (auto end: {r.first().get(), r.last().get()}) {
+            if (end != nullptr && &end->relation() != &r) {
+                violations.push_back(to_string(r.name()) + " relation ends with " + describe(*end));
+            }
+        }
+        r.for_each_node([&](const node& n) {
+            for (std::size_t i = 0; i < static_cast<std::size_t>(pivot::COUNT); ++i) {
+                const auto p = static_cast<pivot>(i);
+                auto target = n.link(p).get();
+                if (target == nullptr) {
+                    continue;
+                }
+                const auto link = describe(n) + " " + to_string(p) + " " + describe(*target);
+                if (&target->graph() != this) {
+                    violations.push_back(link + " is in other graph");
+                    continue;
+                }
+                switch (p) {
+                case pivot::next:
+                case pivot::prev:
+                    if (&target->relation() != &r) {
+                        violations.push_back(link + " is in other relation");
+                    }
+                    if (target->link(p == pivot::next ? pivot::prev : pivot::next).get() != &n) {
+                        violations.push_back(link + " doesn't link back");
+                    }
+                    break;
+                case pivot::parent:
+                    if (!fits(*target, n)) {
+                        violations.push_back(link + " is rejected by relation validator");
+                    }
+                    break;
+                default:
+                    if (!fits(n, *target)) {
+                        violations.push_back(link + " is rejected by relation validator");
+                    }
+                    if (target->parent().get() != &n) {
+                        violations.push_back(link + " has other parent");
+                    }
+                    break;
+                }
+            }
+        });
+    });
+    if (!violations.empty()) {
+        throw error::invalid_graph{std::move(violations)};
+    }
+}
+
+void graph::append_graph(graph&& other) {
+    if (&other == this) {
+        throw std::invalid_argument{"graph can't be appended to itself"};
+    }
+    if (other.listened_()) {
+        throw std::invalid_argument{"appended graph has mutation listeners"};
+    }
+    std::vector<std::pair<relation*, relation*>> pairs;
+    other.for_each_relation([&](relation& r) {
+        auto& dest = at(r.name());
+        if (typeid(dest) != typeid(r)) {
+            throw std::invalid_argument{"appended graph has relation " + to_string(r.name())
+                    + " of other type"};
+        }
+        pairs.emplace_back(&dest, &r);
+    });
+    std::vector<node*> moved;
+    for (auto&& p: pairs) {
+        p.first->absorb_(*p.second, moved);
+    }
+    if (listened_()) {
+        // the handles of shared contents are reported together, so that each but the first
+        // finds the others already known, as if created one by one
+        std::unordered_set<const node*> reported;
+        for (auto n: moved) {
+            if (reported.count(n) != 0) {
+                continue;
+            }
+            auto& feats = n->features();
+            if (nullptr == detail::graph_access::owner(feats)) {
+                detail::graph_access::set_owner(feats, n);
+            }
+            for (auto&& kv: n->relations()) {
+                auto& h = kv.second.get();
+                reported.insert(&h);
+                notify_(&detail::mutation_listener::node_created, h);
+            }
+        }
+        // the moved nodes came with their links and features, which listeners see as changing
+        for (auto n: moved) {
+            for (std::size_t i = 0; i < static_cast<std::size_t>(pivot::COUNT); ++i) {
+                if (const auto p = static_cast<pivot>(i); n->link(p)) {
+                    notify_(&detail::mutation_listener::link_changing, *n, p);
+                }
+            }
+            if (detail::graph_access::owner(n->features()) == n) {
+                for (auto&& kv: n->features()) {
+                    notify_(&detail::mutation_listener::feature_changing, *n, kv.first);
+                }
+            }
+        }
+    }
+    for (auto&& p: pairs) {
+        p.first->join_(*p.second);
+    }
+    other.base::clear();
+}
+
+void graph::add_listener_(detail::mutation_listener& l) {
+    if (listeners_.empty()) {
+        // start routing feature change notifications
+        for_each_relation([](relation& r) {
+            r.for_each_node([](node& n) {
+                auto& feats = n.features();
+                if (nullptr == detail::graph_access::owner(feats)) {
+                    detail::graph_access::set_owner(feats, &n);
+                }
+            });
+        });
+    }
+    listeners_.push_back(&l);
+}
+
+void graph::remove_listener_(detail::mutation_listener& l) noexcept {
+    listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), &l), listeners_.end());
+    if (listeners_.empty()) {
+        for_each_relation([](relation& r) {
+            r.for_each_node([](node& n) {
+                detail::graph_access::set_owner(n.features(), nullptr);
+            });
+        });
+    }
+}
+
+hrglib::journal& graph::start_journal() {
+    if (!journal_) {
+        journal_.reset(new hrglib::journal{*this});
+        add_listener_(*journal_);
+    }
+    return *journal_;
+}
+
+void graph::stop_journal() noexcept {
+    if (journal_) {
+        remove_listener_(*journal_);
+        journal_.reset();
+    }
+}
+
+optional<const hrglib::journal&> graph::journal() const noexcept {
+    if (journal_) {
+        return {*journal_};
+    } else {
+        return {};
+    }
+}
+
+optional<hrglib::journal&> graph::journal() noexcept {
+    if (journal_) {
+        return {*journal_};
+    } else {
+        return {};
+    }
+}
+
 namespace {
 template<typename YamlNode>
 YamlNode& ensure_object(YamlNode& node, const string& name) {
@@ -28,10 +317,6 @@ YamlNode& ensure_object(YamlNode& node, const string& name) {
     return node;
 }
 
-enum struct pivot {
-    next, prev, parent, first_child, last_child, COUNT,
-};
-
 using pivot_setter = decltype(&node::set_next);
 using pivot_getter = node::const_navigator (node::*)() const;
 
@@ -58,27 +343,31 @@ struct arc {
 
     template<typename YamlValue>
     static arc from_yaml(const YamlValue& obj, const string& key, relation_name rel) {
-        const auto end = std::end(pivots);
-        auto it = std::find_if(std::begin(pivots), end,
-                [&](const auto& pe) {
-                    return pe.name == key;
-                });
-        if (end == it) {
-            throw error::parsing_error{"invalid name of relation pivot"};
-        }
-        return {rel, it->setter, it->getter, obj.second.template as<string>()};
+        auto& pe = at_enum(pivots, from_string<pivot>(key));
+        return {rel, pe.setter, pe.getter, obj.second.template as<string>()};
     }
 };
 
+using id_set = std::unordered_set<string>;
+
 struct node_prototype {
     hrglib::features features;
     std::unordered_map<relation_name, string> relations;
     std::vector<arc> arcs;
 
-    void parse_relations(const YAML::Node& rels, const relation::name_mapper_type& nm) {
+    //! @param dropped receives ids of node handles in relations not kept by @p proj.
+    void parse_relations(const YAML::Node& rels, const relation::name_mapper_type& nm,
+            const projection& proj, id_set& dropped)
+    {
         for (auto&& rel_prop: rels) {
             const auto rel_name = rel_prop.first.as<string>();
             auto rel = nm(rel_name);
+            if (!proj.has(rel)) {
+                if (auto id = ensure_object(rel_prop.second, rel_name)["id"]) {
+                    dropped.insert(id.as<string>());
+                }
+                continue;
+            }
             for (auto&& arcs_prop: ensure_object(rel_prop.second, rel_name)) {
                 const auto key = arcs_prop.first.as<string>();
                 if ("id" == key) {
@@ -97,9 +386,10 @@ struct relation_prototype {
     optional<string> last_id;
 };
 
-void build_graph(graph& g, std::vector<node_prototype> nps, std::vector<relation_prototype> rps) {
-    std::unordered_map<string, not_null<node*>> nodes;
-    nodes.reserve(nps.size());
+void build_graph(graph& g, std::vector<node_prototype> nps, std::vector<relation_prototype> rps,
+        const id_set& dropped, detail::node_index& nodes)
+{
+    nodes.reserve(nodes.size() + nps.size());
 
     // first create all the nodes
     for (auto&& np: nps) {
@@ -120,6 +410,8 @@ void build_graph(graph& g, std::vector<node_prototype> nps, std::vector<relation
                 if (auto from = map_find(nodes, *rel_id)) {
                     if (auto to = map_find(nodes, arc.target_id)) {
                         (*from->*arc.setter)(*to);
+                    } else if (dropped.count(arc.target_id) != 0) {
+                        // link into relation dropped by projection, cut it
                     } else {
                         throw error::parsing_error{"missing node id " + arc.target_id};
                     }
@@ -152,10 +444,37 @@ void build_graph(graph& g, std::vector<node_prototype> nps, std::vector<relation
 
 }  // namespace
 
+template<>
+pivot from_string<pivot>(string_view name) {
+    const auto end = std::end(pivots);
+    auto it = std::find_if(std::begin(pivots), end,
+            [&](const auto& pe) {
+                return pe.name == name;
+            });
+    if (end == it) {
+        throw error::parsing_error{"invalid name of relation pivot"};
+    }
+    return static_cast<pivot>(it - std::begin(pivots));
+}
+
+string_view to_string_view(pivot p) {
+    return at_enum(pivots, p).name;
+}
+
 graph graph::from_yaml(const YAML::Node& doc, optional<builder> b) {
+    return graph::from_yaml(doc, projection{}, std::move(b));
+}
+
+graph graph::from_yaml(const YAML::Node& doc, const projection& proj, optional<builder> b) {
     auto g = b.value_or(builder{}).build();
+    detail::load_graph(g, doc, proj);
+    return g;
+}
+
+void detail::load_graph(graph& g, const YAML::Node& doc, const projection& proj, node_index* index) {
     std::vector<node_prototype> nps;
     std::vector<relation_prototype> rps;
+    id_set dropped;
     for (auto&& kv: ensure_object(doc, "document root")) {
         const auto key = kv.first.as<string>();
         if ("nodes" == key) {
@@ -164,22 +483,34 @@ graph graph::from_yaml(const YAML::Node& doc, optional<builder> b) {
             }
             for (auto&& node: kv.second) {
                 node_prototype np;
+                YAML::Node feats;
                 for (auto&& prop: ensure_object(node, "nodes element")) {
                     const auto prop_key = prop.first.as<string>();
                     if ("features" == prop_key) {
-                        np.features = features::from_yaml(prop.second, g.feature_name_mapper());
+                        feats = prop.second;
                     } else if ("relations" == prop_key) {
-                        np.parse_relations(ensure_object(prop.second, prop_key), g.relation_name_mapper());
+                        np.parse_relations(ensure_object(prop.second, prop_key), g.relation_name_mapper(),
+                                proj, dropped);
                     } else {
                         throw error::parsing_error{"invalid node property " + prop_key};
                     }
                 }
+                if (np.relations.empty() && !proj.keeps_all_relations()) {
+                    // all handles dropped by projection, don't bother with features
+                    continue;
+                }
+                if (feats) {
+                    np.features = features::from_yaml(feats, proj, g.feature_name_mapper());
+                }
                 nps.emplace_back(std::move(np));
             }
         } else if ("relations" == key) {
             for (auto&& rel: ensure_object(kv.second, key)) {
                 const auto rel_str = rel.first.as<string>();
                 const auto rel_name = g.relation_name_mapper()(rel_str);
+                if (!proj.has(rel_name)) {
+                    continue;
+                }
                 optional<string> first, last;
                 for (auto&& fl: ensure_object(rel.second, rel_str)) {
                     const auto fl_str = fl.first.as<string>();
@@ -197,38 +528,57 @@ graph graph::from_yaml(const YAML::Node& doc, optional<builder> b) {
             throw error::parsing_error{"invalid root property " + key};
         }
     }
-    build_graph(g, std::move(nps), std::move(rps));
-    return g;
+    node_index local;
+    build_graph(g, std::move(nps), std::move(rps), dropped, index != nullptr ? *index : local);
+    if (g.validation_deferred()) {
+        g.validate();
+    }
 }
 
 graph graph::from_string(string_view yaml, optional<builder> b) {
-    return graph::from_yaml(YAML::Load(string{yaml}), std::move(b));
+    return graph::from_string(yaml, projection{}, std::move(b));
+}
+
+graph graph::from_string(string_view yaml, const projection& proj, optional<builder> b) {
+    return graph::from_yaml(YAML::Load(string{yaml}), proj, std::move(b));
 }
 
 graph graph::from_stream(std::istream& is, optional<builder> b) {
-    return graph::from_yaml(YAML::Load(is), std::move(b));
+    return graph::from_stream(is, projection{}, std::move(b));
+}
+
+graph graph::from_stream(std::istream& is, const projection& proj, optional<builder> b) {
+    return graph::from_yaml(YAML::Load(is), proj, std::move(b));
 }
 
 graph graph::from_file(string_view path, optional<builder> b) {
+    return graph::from_file(path, projection{}, std::move(b));
+}
+
+graph graph::from_file(string_view path, const projection& proj, optional<builder> b) {
     std::ifstream fs{string{path}.c_str()};
-    return graph::from_stream(fs, std::move(b));
+    return graph::from_stream(fs, proj, std::move(b));
 }
 
 YAML::Emitter& operator << (YAML::Emitter& out, const graph& g) {
-    std::unordered_map<const node*, string> nodes;
+    detail::node_ids nodes;
     std::size_t id = 0;
-    for (auto&& rel: g) {
-        for (auto&& n: std::as_const(*rel.second)) {
-            nodes[&n] = std::to_string(id++);
-        }
-    }
+    g.for_each_relation([&](const relation& r) {
+        r.for_each_node([&](const node& n) {
+            nodes.assign(n, std::to_string(id++));
+        });
+    });
+    detail::emit_graph(out, g, nodes);
+    return out;
+}
+
+void detail::emit_graph(YAML::Emitter& out, const graph& g, const node_ids& nodes) {
     out << YAML::BeginMap << YAML::Key << "nodes" << YAML::Value << YAML::BeginSeq;
     std::unordered_set<const features*> feats_seen;
-    for (auto&& rel: g) {
-        for (auto&& nn: std::as_const<relation::base>(*rel.second)) {
-            auto& n = *nn;
+    g.for_each_relation([&](const relation& r) {
+        r.for_each_node([&](const node& n) {
             if (feats_seen.find(&n.features()) != feats_seen.end()) {
-                continue;
+                return;
             }
             feats_seen.insert(&n.features());
             out << YAML::BeginMap << YAML::Key << "features" << YAML::Value << n.features();
@@ -249,18 +599,16 @@ YAML::Emitter& operator << (YAML::Emitter& out, const graph& g) {
                 out << YAML::EndMap;
             }
             out << YAML::EndMap << YAML::EndMap;
-        }
-    }
+        });
+    });
     out << YAML::EndSeq << YAML::Key << "relations" << YAML::Value << YAML::BeginMap;
-    for (auto&& rel: g) {
-        auto& nr = *rel.second;
+    g.for_each_relation([&](const relation& nr) {
         out << YAML::Key << to_string(nr.name()) << YAML::Value << YAML::BeginMap;
         EMIT_NAV(first)
         EMIT_NAV(last)
         out << YAML::EndMap;
-    }
+    });
     out << YAML::EndMap << YAML::EndMap;
-    return out;
 }
 
 std::ostream& operator << (std::ostream& os, const graph& g) {
@@ -0,0 +1,52 @@
+#pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/any.hpp"
+#include "hrglib/pivot.hpp"
+
+#include <utility>
+
+namespace hrglib::detail {
+//! @brief Backdoor to graph internals used by library facilities built on top of it.
+struct graph_access {
+    //! @brief Write link field @p field (which is link @p p of @p n), notifying listeners.
+    static void write(node& n, node*& field, pivot p, node* target) {
+        n.write_(field, p, target);
+    }
+    //! @brief Raw, unvalidated link write; doesn't touch the other end of the link.
+    static void assign_link(node& n, pivot p, node* target) {
+        n.write_(n.link_(p), p, target);
+    }
+    //! @brief Unchecked write of the first and last nodes of @p r, notifying listeners.
+    static void set_ends(relation& r, node* first, node* last) {
+        r.set_first_(first);
+        r.set_last_(last);
+    }
+    static void add_listener(graph& g, mutation_listener& l) {
+        g.add_listener_(l);
+    }
+    static void remove_listener(graph& g, mutation_listener& l) noexcept {
+        g.remove_listener_(l);
+    }
+    //! @brief Node handle routing the change notifications of @p feats, if any.
+    static node* owner(const features& feats) noexcept {
+        return feats.owner_;
+    }
+    static void set_owner(features& feats, node* owner) noexcept {
+        feats.owner_ = owner;
+    }
+    //! @brief Store type-erased @p val at @p feat; @p val must hold `feature_t<feat>`.
+    static void put_feature(features& feats, feature_name feat, any val) {
+        feats.changing_(feat);
+        feats.base::insert_or_assign(feat, std::move(val));
+    }
+    //! @brief Copy type-erased value of @p feat from @p from into @p to.
+    static void copy_feature(const features& from, features& to, feature_name feat) {
+        if (auto val = from.get(feat)) {
+            to.base::insert_or_assign(feat, *val);
+        }
+    }
+};
+}  // namespace hrglib::detail
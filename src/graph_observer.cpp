@@ -0,0 +1,74 @@
+#include "hrglib/graph_observer.hpp"
+#include "hrglib/graph.hpp"
+
+#include "graph_access.hpp"
+
+#include <utility>
+
+namespace hrglib {
+graph_observer::graph_observer(hrglib::graph& g, mutation_kinds kinds, std::size_t batch_size):
+    graph_{g},
+    kinds_{kinds},
+    batch_size_{batch_size}
+{
+    pending_.reserve(batch_size);
+    detail::graph_access::add_listener(g, *this);
+}
+
+graph_observer::~graph_observer() {
+    // on_batch() of the derived class is gone already
+    pending_.clear();
+    detail::graph_access::remove_listener(graph_, *this);
+}
+
+void graph_observer::on_batch(const std::vector<mutation_event>& events) {
+    for (auto&& e: events) {
+        on_mutation(e);
+    }
+}
+
+void graph_observer::flush() {
+    if (pending_.empty()) {
+        return;
+    }
+    // events caused by the handler go to the next batch
+    auto events = std::move(pending_);
+    pending_.clear();
+    pending_.reserve(batch_size_);
+    on_batch(events);
+}
+
+void graph_observer::dispatch_(const mutation_event& e) {
+    if (!kinds_.test(static_cast<std::size_t>(e.kind))) {
+        return;
+    }
+    if (batch_size_ == 0) {
+        on_mutation(e);
+        return;
+    }
+    pending_.push_back(e);
+    if (pending_.size() >= batch_size_) {
+        flush();
+    }
+}
+
+void graph_observer::node_created(node& n) {
+    dispatch_({mutation_kind::node_created, &n});
+}
+
+void graph_observer::node_erasing(node& n) {
+    dispatch_({mutation_kind::node_erasing, &n});
+}
+
+void graph_observer::link_changing(node& n, pivot p) {
+    dispatch_({mutation_kind::link_changing, &n, nullptr, p});
+}
+
+void graph_observer::relation_changing(relation& r) {
+    dispatch_({mutation_kind::relation_changing, nullptr, &r});
+}
+
+void graph_observer::feature_changing(node& n, feature_name feat) {
+    dispatch_({mutation_kind::feature_changing, &n, nullptr, pivot::COUNT, feat});
+}
+}  // namespace hrglib
@@ -0,0 +1,45 @@
+#pragma once
+#include "yaml-cpp_config.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/projection.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/side_table.hpp"
+#include "hrglib/not_null.hpp"
+#include "hrglib/string.hpp"
+
+#include "yaml-cpp.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace hrglib::detail {
+//! @brief Ids under which node handles are written out, in side table per relation.
+class node_ids {
+    std::array<side_table<string>, static_cast<std::size_t>(relation_name::COUNT)> tables_;
+
+    side_table<string>& table_(const node& n) noexcept { return tables_[static_cast<std::size_t>(n.relation_name())]; }
+    const side_table<string>& table_(const node& n) const noexcept {
+        return tables_[static_cast<std::size_t>(n.relation_name())];
+    }
+
+public:
+    void assign(const node& n, string id) { table_(n).set(n, std::move(id)); }
+    //! @throw std::out_of_range if @p n has no id assigned.
+    const string& at(const node* n) const {
+        const auto& res = table_(*n)[*n];
+        if (res.empty()) {
+            throw std::out_of_range{"node without id"};
+        }
+        return res;
+    }
+};
+//! @brief Node handles by the ids they were read with.
+using node_index = std::unordered_map<string, not_null<node*>>;
+
+//! @brief Write @p g as YAML document body, using @p ids for referring to nodes.
+void emit_graph(YAML::Emitter& out, const graph& g, const node_ids& ids);
+//! @brief Populate @p g with relations and nodes read from YAML document @p doc.
+//! @param index if not `nullptr`, receives the handles of created nodes by their ids.
+void load_graph(graph& g, const YAML::Node& doc, const projection& proj, node_index* index = nullptr);
+}  // namespace hrglib::detail
@@ -0,0 +1,197 @@
+#include "hrglib/hierarchy_index.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/error.hpp"
+
+#include "graph_access.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace hrglib {
+hierarchy_index::hierarchy_index(graph& g):
+    graph_{g}
+{
+    detail::graph_access::add_listener(g, *this);
+}
+
+hierarchy_index::~hierarchy_index() {
+    detail::graph_access::remove_listener(graph_, *this);
+}
+
+void hierarchy_index::rebuild_() {
+    ++rebuilds_;
+    nodes_.clear();
+    depths_.clear();
+    ends_.clear();
+    leaves_.clear();
+    leaves_begin_.clear();
+    leaves_end_.clear();
+    for (auto& t: positions_) {
+        t = side_table<std::uint32_t>{none};
+    }
+
+    // children of each node: the ones in its child span first, in order, then any others
+    // pointing at it without being linked from it
+    std::vector<const node*> roots;
+    std::unordered_map<const node*, std::vector<const node*>> children;
+    std::unordered_set<const node*> spanned;
+    graph_.for_each_relation([&](const relation& r) {
+        r.for_each_node([&](const node& n) {
+            if (!n.parent()) {
+                roots.push_back(&n);
+            }
+            for (auto c = n.first_child().get(); c != nullptr; c = c->next().get()) {
+                if (c->parent().get() == &n) {
+                    children[&n].push_back(c);
+                    spanned.insert(c);
+                }
+                if (c == n.last_child().get()) {
+                    break;
+                }
+            }
+        });
+    });
+    graph_.for_each_relation([&](const relation& r) {
+        r.for_each_node([&](const node& n) {
+            if (n.parent() && spanned.count(&n) == 0) {
+                children[n.parent().get()].push_back(&n);
+            }
+        });
+    });
+    const std::vector<const node*> no_children;
+    const auto children_of = [&](const node* n) -> const std::vector<const node*>& {
+        const auto it = children.find(n);
+        return it != children.end() ? it->second : no_children;
+    };
+
+    // iterative depth-first numbering
+    std::vector<std::uint32_t> parents;
+    struct frame {
+        const node* n;
+        std::uint32_t position;
+        std::size_t next_child;
+    };
+    std::vector<frame> stack;
+    const auto enter = [&](const node* n, std::uint32_t parent) {
+        const auto i = static_cast<std::uint32_t>(nodes_.size());
+        positions_[static_cast<std::size_t>(n->relation_name())][*n] = i;
+        nodes_.push_back(n);
+        parents.push_back(parent);
+        depths_.push_back(parent != none ? depths_[parent] + 1 : 0);
+        ends_.push_back(none);
+        leaves_begin_.push_back(static_cast<std::uint32_t>(leaves_.size()));
+        leaves_end_.push_back(none);
+        if (children_of(n).empty()) {
+            leaves_.push_back(n);
+        }
+        stack.push_back({n, i, 0});
+    };
+    for (auto root: roots) {
+        enter(root, none);
+        while (!stack.empty()) {
+            auto& top = stack.back();
+            const auto& kids = children_of(top.n);
+            if (top.next_child < kids.size()) {
+                enter(kids[top.next_child++], top.position);
+                continue;
+            }
+            ends_[top.position] = static_cast<std::uint32_t>(nodes_.size());
+            leaves_end_[top.position] = static_cast<std::uint32_t>(leaves_.size());
+            stack.pop_back();
+        }
+    }
+
+    jumps_.assign(1, std::move(parents));
+    for (std::size_t k = 1; (std::size_t{1} << k) <= nodes_.size(); ++k) {
+        const auto& prev = jumps_[k - 1];
+        std::vector<std::uint32_t> level(nodes_.size(), none);
+        for (std::size_t i = 0; i < nodes_.size(); ++i) {
+            if (prev[i] != none) {
+                level[i] = prev[prev[i]];
+            }
+        }
+        jumps_.push_back(std::move(level));
+    }
+    valid_ = true;
+}
+
+std::uint32_t hierarchy_index::position_(const node& n) {
+    if (!valid_) {
+        rebuild_();
+    }
+    const auto i = std::as_const(positions_[static_cast<std::size_t>(n.relation_name())])[n];
+    if (i == none) {
+        throw error::bad_node{"node is not in any hierarchy tree"};
+    }
+    return i;
+}
+
+std::uint32_t hierarchy_index::ascend_(std::uint32_t i, std::uint32_t levels) const noexcept {
+    for (std::size_t k = 0; levels != 0 && i != none; ++k, levels >>= 1) {
+        if (levels & 1u) {
+            i = jumps_[k][i];
+        }
+    }
+    return i;
+}
+
+std::size_t hierarchy_index::depth(const node& n) {
+    return depths_[position_(n)];
+}
+
+node::const_navigator hierarchy_index::ancestor(const node& n, std::size_t d) {
+    const auto i = position_(n);
+    if (d > depths_[i]) {
+        return {};
+    }
+    return {nodes_[ascend_(i, depths_[i] - static_cast<std::uint32_t>(d))]};
+}
+
+bool hierarchy_index::is_ancestor(const node& a, const node& n) {
+    const auto i = position_(a);
+    const auto j = position_(n);
+    return i <= j && j < ends_[i];
+}
+
+node::const_navigator hierarchy_index::lca(const node& a, const node& b) {
+    auto i = position_(a);
+    auto j = position_(b);
+    if (depths_[i] > depths_[j]) {
+        std::swap(i, j);
+    }
+    j = ascend_(j, depths_[j] - depths_[i]);
+    if (i == j) {
+        return {nodes_[i]};
+    }
+    for (auto k = jumps_.size(); k-- > 0;) {
+        if (jumps_[k][i] != jumps_[k][j]) {
+            i = jumps_[k][i];
+            j = jumps_[k][j];
+        }
+    }
+    if (jumps_[0][i] == none) {
+        return {};
+    }
+    return {nodes_[jumps_[0][i]]};
+}
+
+iterator::range<hierarchy_index::leaf_iterator> hierarchy_index::leaves(const node& n) {
+    const auto i = position_(n);
+    return {leaves_.cbegin() + leaves_begin_[i], leaves_.cbegin() + leaves_end_[i]};
+}
+
+void hierarchy_index::node_created(node&) {
+    valid_ = false;
+}
+
+void hierarchy_index::node_erasing(node&) {
+    valid_ = false;
+}
+
+void hierarchy_index::link_changing(node&, pivot) {
+    valid_ = false;
+}
+}  // namespace hrglib
@@ -0,0 +1,275 @@
+#include "yaml-cpp_config.hpp"
+#include "hrglib/journal.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+
+#include "graph_access.hpp"
+#include "graph_yaml.hpp"
+#include "delta.hpp"
+#include "yaml-cpp.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace hrglib {
+journal::journal(const hrglib::graph& g):
+    graph_{&g}
+{
+    g.for_each_relation([this](const relation& r) {
+        r.for_each_node([this](const node& n) {
+            ids_.emplace(&n, next_id_++);
+        });
+    });
+}
+
+void journal::node_created(node& n) {
+    const auto id = next_id_++;
+    ids_.emplace(&n, id);
+    optional<std::size_t> shares;
+    // nodes moved in from other graph come with all their handles, not all reported yet
+    for (auto&& kv: n.relations()) {
+        if (&kv.second.get() != &n) {
+            if (auto other = map_find(ids_, &kv.second.get())) {
+                shares = *other;
+                break;
+            }
+        }
+    }
+    created_.push_back({id, n.relation_name(), shares});
+}
+
+void journal::node_erasing(node& n) {
+    auto it = ids_.find(&n);
+    assert(it != ids_.end());
+    erased_.push_back(it->second);
+    ids_.erase(it);
+    links_.erase(&n);
+    if (auto fe = features_.find(&n.features()); fe != features_.end()) {
+        if (n.relations().size() == 1) {
+            // contents go away together with the last handle
+            features_.erase(fe);
+        } else if (fe->second.handle == &n) {
+            for (auto&& kv: n.relations()) {
+                if (&kv.second.get() != &n) {
+                    fe->second.handle = &kv.second.get();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void journal::link_changing(node& n, pivot p) {
+    links_[&n].set(static_cast<std::size_t>(p));
+}
+
+void journal::relation_changing(relation& r) {
+    relations_.insert(r.name());
+}
+
+void journal::feature_changing(node& n, feature_name feat) {
+    features_.try_emplace(&n.features(), features_entry{&n, {}}).first->second.changed.insert(feat);
+}
+
+std::size_t journal::id(const node& n) const {
+    if (auto id = map_find(ids_, &n)) {
+        return *id;
+    } else {
+        throw error::bad_node{"node unknown to journal"};
+    }
+}
+
+bool journal::empty() const noexcept {
+    return created_.empty() && erased_.empty() && links_.empty()
+            && features_.empty() && relations_.empty();
+}
+
+void journal::clear() noexcept {
+    created_.clear();
+    erased_.clear();
+    links_.clear();
+    features_.clear();
+    relations_.clear();
+}
+
+void journal::snapshot(YAML::Emitter& out) {
+    detail::node_ids ids;
+    for (auto&& kv: ids_) {
+        ids.assign(*kv.first, std::to_string(kv.second));
+    }
+    out << YAML::BeginDoc;
+    detail::emit_graph(out, *graph_, ids);
+    clear();
+}
+
+detail::delta journal::collect_() const {
+    detail::delta d;
+    d.created.reserve(created_.size());
+    for (auto&& ce: created_) {
+        d.created.push_back({ce.id, ce.relation, ce.shares});
+    }
+    d.erased = erased_;
+    d.linked.reserve(links_.size());
+    for (auto&& kv: links_) {
+        auto& lu = d.linked.emplace_back();
+        lu.id = ids_.at(kv.first);
+        for (std::size_t i = 0; i < kv.second.size(); ++i) {
+            if (kv.second.test(i)) {
+                const auto p = static_cast<pivot>(i);
+                const auto target = kv.first->link(p);
+                lu.links.push_back({p, target ? optional<std::size_t>{ids_.at(target.get())} : nullopt});
+            }
+        }
+    }
+    d.updated.reserve(features_.size());
+    for (auto&& kv: features_) {
+        const auto& feats = *kv.first;
+        auto& fu = d.updated.emplace_back();
+        fu.id = ids_.at(kv.second.handle);
+        for (auto feat: kv.second.changed) {
+            if (feats.has(feat)) {
+                detail::graph_access::copy_feature(feats, fu.set, feat);
+            } else {
+                fu.removed.push_back(feat);
+            }
+        }
+    }
+    d.bounds.reserve(relations_.size());
+    for (auto rel: relations_) {
+        auto& r = *graph_->get(rel);
+        auto id_of = [this](const node* n) {
+            return n != nullptr ? optional<std::size_t>{ids_.at(n)} : nullopt;
+        };
+        d.bounds.push_back({rel, id_of(r.first().get()), id_of(r.last().get())});
+    }
+    return d;
+}
+
+void journal::flush(YAML::Emitter& out) {
+    out << YAML::BeginDoc;
+    detail::emit_delta(out, collect_());
+    clear();
+}
+
+void journal::snapshot(std::ostream& os) {
+    YAML::Emitter out{os};
+    snapshot(out);
+    os << '\n';
+}
+
+void journal::flush(std::ostream& os, stream_format fmt) {
+    detail::write_delta(os, collect_(), fmt);
+    clear();
+}
+
+replica::replica(optional<hrglib::graph::builder> b):
+    graph_{b.value_or(graph::builder{}).build()}
+{}
+
+replica::replica(const YAML::Node& snapshot, optional<hrglib::graph::builder> b):
+    replica{std::move(b)}
+{
+    detail::node_index index;
+    detail::load_graph(graph_, snapshot, projection{}, &index);
+    nodes_.reserve(index.size());
+    for (auto&& kv: index) {
+        std::size_t pos = 0;
+        std::size_t id = 0;
+        try {
+            id = std::stoul(kv.first, &pos);
+        } catch (const std::logic_error&) {
+            pos = 0;
+        }
+        if (pos == 0 || pos != kv.first.size()) {
+            throw error::parsing_error{"snapshot node id is not numeric: " + kv.first};
+        }
+        nodes_.emplace(id, kv.second);
+    }
+}
+
+replica::replica(std::istream& is, optional<hrglib::graph::builder> b):
+    replica{YAML::Load(is), std::move(b)}
+{}
+
+node& replica::node_at(std::size_t id) const {
+    if (auto n = map_find(nodes_, id)) {
+        return **n;
+    } else {
+        throw error::parsing_error{"missing node id " + std::to_string(id)};
+    }
+}
+
+void replica::apply_(const detail::delta& d) {
+    auto& g = graph_;
+    // Order matters: new handles may share contents of erased ones, links and features
+    // may refer to handles created in this delta.
+    for (auto&& ce: d.created) {
+        auto& n = g[ce.relation].create(ce.shares ? &node_at(*ce.shares) : nullptr);
+        if (!nodes_.emplace(ce.id, &n).second) {
+            throw error::parsing_error{"duplicate node id " + std::to_string(ce.id)};
+        }
+    }
+    for (auto id: d.erased) {
+        auto& n = node_at(id);
+        n.relation().erase(n);
+        nodes_.erase(id);
+    }
+    for (auto&& lu: d.linked) {
+        auto& n = node_at(lu.id);
+        for (auto&& l: lu.links) {
+            // links come in final state, so they are assigned one by one
+            // without the side effects of validating setters
+            detail::graph_access::assign_link(n, l.which, l.target ? &node_at(*l.target) : nullptr);
+        }
+    }
+    for (auto&& fu: d.updated) {
+        auto& feats = node_at(fu.id).features();
+        for (auto feat: fu.removed) {
+            feats.erase(feat);
+        }
+        feats.update(fu.set);
+    }
+    for (auto&& re: d.bounds) {
+        auto& r = g[re.relation];
+        r.set_first(re.first ? &node_at(*re.first) : nullptr);
+        r.set_last(re.last ? &node_at(*re.last) : nullptr);
+    }
+}
+
+replica& replica::apply(const YAML::Node& doc) {
+    apply_(detail::load_delta(doc, graph_));
+    return *this;
+}
+
+bool replica::apply_next(std::istream& is, stream_format fmt) {
+    if (auto d = detail::read_delta(is, fmt, graph_)) {
+        apply_(*d);
+        return true;
+    }
+    return false;
+}
+
+replica& replica::apply(std::istream& is, stream_format fmt) {
+    if (stream_format::yaml == fmt) {
+        // documents written with YAML::Emitter overloads need not be terminated with `...`
+        for (auto&& doc: YAML::LoadAll(is)) {
+            apply(doc);
+        }
+    } else {
+        while (apply_next(is, fmt)) {}
+    }
+    return *this;
+}
+
+replica& replica::apply(string_view yaml) {
+    std::istringstream is{string{yaml}};
+    return apply(is);
+}
+}  // namespace hrglib
@@ -7,13 +7,18 @@
 #include "hrglib/token.hpp"
 #include "hrglib/word.hpp"
 #include "hrglib/syllable.hpp"
+#include "hrglib/phrase.hpp"
 #include "hrglib/optional.hpp"
+#include "hrglib/mutation_listener.hpp"
+
+#include "graph_access.hpp"
 
 #include <typeinfo>
 #include <utility>
 #include <unordered_map>
 #include <cassert>
 #include <stdexcept>
+#include <cstdlib>
 
 namespace hrglib {
 
@@ -47,7 +52,11 @@ node::contents& node::attach_contents(const hrglib::relation& r, node* in_other_
         cont.relations.emplace(r.name(), std::ref(*this));
         return cont;
     } else {
-        return *new contents{{}, {{r.name(), std::ref(*this)}}};
+        auto& cont = *new contents{{}, {{r.name(), std::ref(*this)}}};
+        if (r.graph().listened_()) {
+            cont.features.owner_ = this;
+        }
+        return cont;
     }
 }
 
@@ -63,6 +72,9 @@ void node::release_contents(const hrglib::relation& r) noexcept {
         assert(this == &map_find(cont_.relations, r.name())->get());
         auto num = cont_.relations.erase(r.name());
         assert(1 == num); (void) num;
+        if (this == cont_.features.owner_) {
+            cont_.features.owner_ = &cont_.relations.begin()->second.get();
+        }
     }
 }
 
@@ -90,27 +102,54 @@ node::navigator node::as(hrglib::relation_name rel) noexcept {
     }
 }
 
+node*& node::link_(pivot p) noexcept {
+    switch (p) {
+    case pivot::next: return next_;
+    case pivot::prev: return prev_;
+    case pivot::parent: return parent_;
+    case pivot::first_child: return first_child_;
+    case pivot::last_child: return last_child_;
+    default:
+        assert(!"invalid pivot");
+        std::abort();
+    }
+}
+
+void node::write_(node*& field, pivot p, node* n) {
+    if (field != n) {
+        if (auto& g = graph(); g.listened_()) {
+            g.notify_(&detail::mutation_listener::link_changing, *this, p);
+        }
+        if (p == pivot::next || p == pivot::prev) {
+            ++rel_->sequence_version_;
+        }
+        field = n;
+    }
+}
+
 inline void node::unlink_next() {
     if (next_ != nullptr) {
         assert(this == next_->prev_);
-        next_->prev_ = nullptr;
+        next_->write_(next_->prev_, pivot::prev, nullptr);
     }
 }
 
 inline void node::unlink_prev() {
     if (prev_ != nullptr) {
         assert(this == prev_->next_);
-        prev_->next_ = nullptr;
+        prev_->write_(prev_->next_, pivot::next, nullptr);
     }
 }
 
 inline void node::unlink_parent() {
     if (auto parent = static_cast<node*>(parent_); parent != nullptr) {
+        // only child leaves no children behind, even if its siblings have other parents
+        const bool only = this == parent->first_child_ && this == parent->last_child_;
         if (this == parent->first_child_) {
-            parent->first_child_ = next_;
+            parent->write_(parent->first_child_, pivot::first_child, only ? nullptr : next_);
         }
         if (this == parent->last_child_) {
-            parent->last_child_ = prev_;
+            parent->write_(parent->last_child_, pivot::last_child, only ? nullptr : prev_);
         }
     }
 }
@@ -119,7 +158,7 @@ inline void node::unlink_children() {
     if (first_child_ != nullptr) {
         for (auto child = first_child_; child != nullptr; child = child->next_) {
             assert(this == child->parent_);
-            child->parent_ = nullptr;
+            child->write_(child->parent_, pivot::parent, nullptr);
             if (last_child_ == child) {
                 // don't go beyond last_child if relation closed
                 break;
@@ -133,29 +172,36 @@ node::~node() noexcept {
     unlink_parent();
     unlink_prev();
     unlink_next();
-    release_contents(rel_);
+    release_contents(*rel_);
 }
 
 node& node::set_next_(node* n) {
     if (next_ == n) {
         return *this;
     }
-    if (nullptr != n && &relation() != &n->relation()) {
-        throw error::bad_relation{n->relation().name()};
-    }
     // break the link in both direction
     unlink_next();
     // set new next
-    if ((next_ = n) != nullptr) {
+    write_(next_, pivot::next, n);
+    if (n != nullptr) {
         // break also old link from new next
         n->unlink_prev();
         // setup link in both directions
-        next_->prev_ = this;
+        n->write_(n->prev_, pivot::prev, this);
     }
     return *this;
 }
 
 node& node::set_next(node* n) {
+    if (nullptr != n && &relation() != &n->relation()) {
+        if (!graph().deferred_validation_) {
+            throw error::bad_relation{n->relation().name()};
+        }
+        // left to graph::validate(), unless it would write into other graph
+        if (&graph() != &n->graph()) {
+            throw std::invalid_argument{"linked nodes must be in the same graph"};
+        }
+    }
     return set_next_(n);
 }
 
@@ -163,18 +209,25 @@ node& node::set_prev_(node* n) {
     if (prev_ == n) {
         return *this;
     }
-    if (nullptr != n && &relation() != &n->relation()) {
-        throw error::bad_relation{n->relation().name()};
-    }
     unlink_prev();
-    if ((prev_ = n) != nullptr) {
+    write_(prev_, pivot::prev, n);
+    if (n != nullptr) {
         n->unlink_next();
-        prev_->next_ = this;
+        n->write_(n->next_, pivot::next, this);
     }
     return *this;
 }
 
 node& node::set_prev(node* n) {
+    if (nullptr != n && &relation() != &n->relation()) {
+        if (!graph().deferred_validation_) {
+            throw error::bad_relation{n->relation().name()};
+        }
+        // left to graph::validate(), unless it would write into other graph
+        if (&graph() != &n->graph()) {
+            throw std::invalid_argument{"linked nodes must be in the same graph"};
+        }
+    }
     return set_prev_(n);
 }
 
@@ -186,49 +239,59 @@ node& node::set_parent_(node* p) {
         throw std::invalid_argument{"linked nodes must be in the same graph"};
     }
     unlink_parent();
-    parent_ = p;
+    write_(parent_, pivot::parent, p);
     return *this;
 }
 
+bool node::typed_links_valid_() const noexcept {
+    return graph().default_relation_validator_;
+}
+
+bool node::allows_child_(const node& c) const {
+    const auto& g = graph();
+    return g.default_relation_validator_
+            ? is_valid_link(relation_name(), c.relation_name())
+            : g.relation_validator()(relation(), c.relation());
+}
+
 node& node::set_parent(node* p) {
-    if (nullptr != p && !relation_validator()(p->relation(), relation())) {
+    if (nullptr != p && !graph().deferred_validation_ && !p->allows_child_(*this)) {
         throw error::bad_relation{p->relation().name()};
     }
     return set_parent_(p);
 }
 
-namespace {
-inline node& node_set_child(node& self, node*& field, node* c) {
+node& node::set_child_(node*& field, pivot p, node* c) {
     if (field == c) {
-        return self;
+        return *this;
     }
-    if (nullptr != c && &self.graph() != &c->graph()) {
+    if (nullptr != c && &graph() != &c->graph()) {
         throw std::invalid_argument{"linked nodes must be in the same graph"};
     }
-    if ((field = c) != nullptr) {
-        c->set_parent(&self);
+    write_(field, p, c);
+    if (c != nullptr) {
+        c->set_parent_(this);
     }
-    return self;
-}
+    return *this;
 }
 
 node& node::set_first_child_(node* c) {
-    return node_set_child(*this, first_child_, c);
+    return set_child_(first_child_, pivot::first_child, c);
 }
 
 node& node::set_last_child_(node* c) {
-    return node_set_child(*this, last_child_, c);
+    return set_child_(last_child_, pivot::last_child, c);
 }
 
 node& node::set_first_child(node* c) {
-    if (nullptr != c && !relation_validator()(relation(), c->relation())) {
+    if (nullptr != c && !graph().deferred_validation_ && !allows_child_(*c)) {
         throw error::bad_relation{c->relation().name()};
     }
     return set_first_child_(c);
 }
 
 node& node::set_last_child(node* c) {
-    if (nullptr != c && !relation_validator()(relation(), c->relation())) {
+    if (nullptr != c && !graph().deferred_validation_ && !allows_child_(*c)) {
         throw error::bad_relation{c->relation().name()};
     }
     return set_last_child_(c);
@@ -245,6 +308,7 @@ unique_ptr<node> node::default_factory::operator()(rel_t& r, node* c) const {
     HANDLE_CASE(Token)
     HANDLE_CASE(Word)
     HANDLE_CASE(Syllable)
+    HANDLE_CASE(Phrase)
 #undef HANDLE_CASE
     default:
         throw error::bad_relation{r.name()};
@@ -252,35 +316,23 @@ unique_ptr<node> node::default_factory::operator()(rel_t& r, node* c) const {
 }
 
 bool node::default_relation_validator::operator()(const hrglib::relation& parent, const hrglib::relation& child) const {
-#define CHECK_RELATION_TRAIS(relation) \
-    if (child.name() == R:: relation && parent_relation<R:: relation> == parent.name() || \
-        parent.name() == R:: relation && child_relation<R:: relation> == child.name()) \
-    { \
-        return true; \
-    }
-    // TODO handle all default relations
-    // HRGLIB_RELATION_LIST(CHECK_RELATION_TRAIS)
-    CHECK_RELATION_TRAIS(Token)
-    CHECK_RELATION_TRAIS(Word)
-    CHECK_RELATION_TRAIS(Syllable)
-#undef CHECK_RELATION_TRAIS
-    return false;
+    return is_valid_link(parent.name(), child.name());
 }
 
 node& node::insert_next(node* in_other_relation) {
-    auto& res = rel_.create(in_other_relation);
+    auto& res = rel_->create(in_other_relation);
     set_next_(&res.set_next_(next_));
-    if (rel_.last() == this) {
-        rel_.set_last(&res);
+    if (rel_->last() == this) {
+        rel_->set_last(&res);
     }
     return res;
 }
 
 node& node::insert_prev(node* in_other_relation) {
-    auto& res = rel_.create(in_other_relation);
+    auto& res = rel_->create(in_other_relation);
     set_prev_(&res.set_prev_(prev_));
-    if (rel_.first() == this) {
-        rel_.set_first(&res);
+    if (rel_->first() == this) {
+        rel_->set_first(&res);
     }
     return res;
 }
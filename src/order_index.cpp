@@ -0,0 +1,168 @@
+#include "hrglib/order_index.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+
+#include "graph_access.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace hrglib {
+namespace {
+constexpr auto max_key = std::numeric_limits<order_index::key_type>::max();
+//! Spacing that must be left between neighbours after relabelling partial window.
+constexpr order_index::key_type min_spacing = order_index::key_type{1} << 16;
+}  // namespace
+
+order_index::order_index(hrglib::relation& rel):
+    relation_{rel},
+    labels_{rel},
+    ranks_{rel}
+{
+    std::vector<const node*> all;
+    for (auto&& n: std::as_const(rel)) {
+        all.push_back(&n);
+    }
+    spread_(all, nullptr, nullptr);
+    detail::graph_access::add_listener(rel.graph(), *this);
+}
+
+order_index::~order_index() {
+    detail::graph_access::remove_listener(relation_.graph(), *this);
+}
+
+bool order_index::spread_(const std::vector<const node*>& run, const node* lo, const node* hi) {
+    const key_type low = lo != nullptr ? labels_[*lo] : 0;
+    const key_type high = hi != nullptr ? labels_[*hi] : max_key;
+    if (high <= low) {
+        return false;
+    }
+    const auto step = (high - low) / (run.size() + 1);
+    // the whole relation has to fit whatever the spacing
+    const auto needed = lo == nullptr && hi == nullptr ? 1 : min_spacing;
+    if (step < needed) {
+        return false;
+    }
+    auto label = low;
+    for (auto n: run) {
+        labels_[*n] = label += step;
+    }
+    return true;
+}
+
+void order_index::relabel_(std::vector<const node*> run) {
+    // unchanged neighbours of the run; they are in order relative to each other
+    auto lo = run.front()->prev().get();
+    auto hi = run.back()->next().get();
+    if (spread_(run, lo, hi)) {
+        return;
+    }
+    ++relabels_;
+    std::vector<const node*> before;
+    std::vector<const node*> after;
+    for (std::size_t widen = 1;; widen *= 2) {
+        for (std::size_t i = before.size(); i < widen && lo != nullptr; ++i) {
+            before.push_back(lo);
+            lo = lo->prev().get();
+        }
+        for (std::size_t i = after.size(); i < widen && hi != nullptr; ++i) {
+            after.push_back(hi);
+            hi = hi->next().get();
+        }
+        std::vector<const node*> window(before.rbegin(), before.rend());
+        window.insert(window.end(), run.begin(), run.end());
+        window.insert(window.end(), after.begin(), after.end());
+        if (spread_(window, lo, hi) || (lo == nullptr && hi == nullptr)) {
+            return;
+        }
+    }
+}
+
+void order_index::flush_() {
+    std::vector<const node*> runs;
+    while (!pending_.empty()) {
+        auto n = *pending_.begin();
+        // maximal run of changed nodes around n
+        auto first = n;
+        while (auto p = first->prev().get()) {
+            if (pending_.count(p) == 0) {
+                break;
+            }
+            first = p;
+        }
+        std::vector<const node*> run;
+        for (auto x = first; x != nullptr && pending_.erase(x) != 0; x = x->next().get()) {
+            run.push_back(x);
+        }
+        relabel_(std::move(run));
+        runs.push_back(first);
+    }
+    // compared only once all the labels are final
+    for (auto first: runs) {
+        stale_from_node_(first);
+    }
+}
+
+void order_index::stale_from_node_(const node* n) {
+    if (!ranks_valid_) {
+        return;
+    }
+    if (n->prev() == nullptr && relation_.first().get() != n) {
+        // not in the sequence, can't tell where the change was
+        ranks_valid_ = false;
+        stale_from_ = nullptr;
+    } else if (stale_from_ == nullptr || labels_[*n] < labels_[*stale_from_]) {
+        stale_from_ = n;
+    }
+}
+
+order_index::key_type order_index::key(const node& n) {
+    flush_();
+    return labels_[n];
+}
+
+std::size_t order_index::rank(const node& n) {
+    flush_();
+    if (!ranks_valid_ || stale_from_ != nullptr) {
+        ranks_.reserve(relation_);
+        auto x = ranks_valid_ ? stale_from_ : relation_.first().get();
+        auto p = x != nullptr ? x->prev().get() : nullptr;
+        for (auto i = p != nullptr ? ranks_[*p] + 1 : 0; x != nullptr; x = x->next().get()) {
+            ranks_[*x] = i++;
+            ++renumbered_;
+        }
+        ranks_valid_ = true;
+        stale_from_ = nullptr;
+    }
+    return ranks_[n];
+}
+
+void order_index::node_created(node& n) {
+    if (&n.relation() == &relation_) {
+        pending_.insert(&n);
+    }
+}
+
+void order_index::node_erasing(node& n) {
+    if (&n.relation() == &relation_) {
+        pending_.erase(&n);
+        if (&n == stale_from_) {
+            // whatever precedes it is earlier still
+            stale_from_ = nullptr;
+            if (auto p = n.prev().get()) {
+                stale_from_node_(p);
+            } else {
+                ranks_valid_ = false;
+            }
+        }
+    }
+}
+
+void order_index::link_changing(node& n, pivot p) {
+    if ((p == pivot::next || p == pivot::prev) && &n.relation() == &relation_) {
+        pending_.insert(&n);
+    }
+}
+}  // namespace hrglib
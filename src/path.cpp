@@ -0,0 +1,108 @@
+#include "hrglib/path.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+#include "hrglib/memory.hpp"
+#include "hrglib/pivot.hpp"
+
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace hrglib {
+namespace {
+constexpr auto pivot_count = static_cast<std::size_t>(pivot::COUNT);
+static_assert(pivot_count + static_cast<std::size_t>(relation_name::COUNT) <= UINT8_MAX,
+        "path opcodes don't fit in a byte");
+
+constexpr string_view relation_prefix = "R:";
+
+//! Festival names of the links, accepted along with `pivot` names.
+const std::unordered_map<string_view, pivot> festival_steps = {
+    {"n", pivot::next},
+    {"p", pivot::prev},
+    {"daughter1", pivot::first_child},
+    {"daughtern", pivot::last_child},
+};
+
+std::uint8_t compile_step(string_view expr, string_view step) {
+    if (step.substr(0, relation_prefix.size()) == relation_prefix) {
+        try {
+            const auto rel = from_string<relation_name>(step.substr(relation_prefix.size()));
+            return static_cast<std::uint8_t>(pivot_count + static_cast<std::size_t>(rel));
+        } catch (const error::parsing_error& e) {
+            throw error::invalid_path{string{expr}, e.what()};
+        }
+    }
+    if (auto p = map_find(festival_steps, step)) {
+        return static_cast<std::uint8_t>(*p);
+    }
+    try {
+        return static_cast<std::uint8_t>(from_string<pivot>(step));
+    } catch (const error::parsing_error&) {
+        throw error::invalid_path{string{expr}, "unknown step \"" + string{step} + "\""};
+    }
+}
+
+std::mutex cache_mutex;
+//! Keys view the expressions owned by the cached paths.
+std::unordered_map<string_view, unique_ptr<const path>> cache;
+}  // namespace
+
+path::path(string expr, std::vector<op> ops, feature_name feat) noexcept:
+    expr_{std::move(expr)},
+    ops_{std::move(ops)},
+    feature_{feat}
+{}
+
+path path::compile(string_view expr) {
+    std::vector<op> ops;
+    string_view rest = expr;
+    for (auto dot = rest.find('.'); dot != string_view::npos; dot = rest.find('.')) {
+        const auto step = rest.substr(0, dot);
+        if (step.empty()) {
+            throw error::invalid_path{string{expr}, "empty step"};
+        }
+        ops.push_back(compile_step(expr, step));
+        rest.remove_prefix(dot + 1);
+    }
+    if (rest.empty()) {
+        throw error::invalid_path{string{expr}, "missing feature name"};
+    }
+    try {
+        const auto feat = from_string<feature_name>(rest);
+        ops.shrink_to_fit();
+        return path{string{expr}, std::move(ops), feat};
+    } catch (const error::parsing_error& e) {
+        throw error::invalid_path{string{expr}, e.what()};
+    }
+}
+
+const path& path::cached(string_view expr) {
+    std::lock_guard<std::mutex> lock{cache_mutex};
+    if (auto p = map_find(cache, expr)) {
+        return **p;
+    }
+    auto p = std::make_unique<const path>(compile(expr));
+    auto& res = *p;
+    cache.emplace(res.expression(), std::move(p));
+    return res;
+}
+
+const node* path::walk_(const node* n) const noexcept {
+    for (auto it = ops_.begin(); n != nullptr && it != ops_.end(); ++it) {
+        n = *it < pivot_count
+            ? n->link(static_cast<pivot>(*it)).get()
+            : n->as(static_cast<relation_name>(*it - pivot_count)).get();
+    }
+    return n;
+}
+
+optional<const any&> path::operator()(const node& n) const {
+    if (auto t = walk_(&n)) {
+        return t->features().get(feature_);
+    }
+    return {};
+}
+}  // namespace hrglib
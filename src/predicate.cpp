@@ -0,0 +1,236 @@
+#include "hrglib/predicate.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/any.hpp"
+
+#include "feature_codec.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace hrglib {
+struct predicate::term {
+    enum struct kind { all, has, compare, in, shift, conjunction, disjunction, negation };
+
+    kind what = kind::all;
+    feature_name feature{};
+    comparison cmp{};
+    std::uint64_t value = 0;
+    //! @brief Sorted values for `in`.
+    std::vector<string> values;
+    //! @brief Offset of the node whose result is taken for `shift`.
+    std::ptrdiff_t offset = 0;
+    std::shared_ptr<const term> lhs;
+    std::shared_ptr<const term> rhs;
+};
+
+namespace {
+using term = predicate::term;
+using kind = term::kind;
+
+//! @brief Feature values of all the evaluated nodes, gathered once per evaluation.
+struct column {
+    node_mask present;
+    std::vector<std::uint64_t> values;
+};
+
+class evaluator {
+    const std::vector<const node*>& nodes_;
+    std::unordered_map<feature_name, column> columns_;
+
+    const column& column_(feature_name feat) {
+        auto [it, inserted] = columns_.try_emplace(feat);
+        auto& col = it->second;
+        if (inserted) {
+            col.present = node_mask{nodes_.size()};
+            col.values.assign(nodes_.size(), 0);
+            const bool integral = detail::feature_is_integral(feat);
+            for (std::size_t i = 0; i < nodes_.size(); ++i) {
+                if (auto v = nodes_[i]->features().get(feat)) {
+                    col.present.set(i);
+                    if (integral) {
+                        col.values[i] = detail::feature_value_to_uint(feat, *v);
+                    }
+                }
+            }
+        }
+        return col;
+    }
+
+    //! @brief Pack results of @p match for all the nodes into mask, a word at a time.
+    template<typename Match>
+    node_mask pack_(Match&& match) const {
+        node_mask res{nodes_.size()};
+        auto& words = res.words();
+        for (std::size_t w = 0; w < words.size(); ++w) {
+            const auto begin = w * node_mask::word_bits;
+            const auto end = std::min(begin + node_mask::word_bits, nodes_.size());
+            node_mask::word_type bits = 0;
+            for (auto i = begin; i < end; ++i) {
+                bits |= node_mask::word_type{match(i)} << (i - begin);
+            }
+            words[w] = bits;
+        }
+        return res;
+    }
+
+    template<typename Compare>
+    node_mask compare_(const column& col, std::uint64_t value, Compare cmp) const {
+        const auto* values = col.values.data();
+        return pack_([=](std::size_t i) { return cmp(values[i], value); }) & col.present;
+    }
+
+    node_mask in_(const term& t) {
+        const auto& sorted = t.values;
+        return pack_([&](std::size_t i) {
+            auto v = nodes_[i]->features().get(t.feature);
+            if (!v) {
+                return false;
+            }
+            if (auto s = any_cast<string>(&*v)) {
+                return std::binary_search(sorted.begin(), sorted.end(), *s);
+            }
+            return std::binary_search(sorted.begin(), sorted.end(), detail::format_feature_value(t.feature, *v));
+        });
+    }
+
+public:
+    explicit evaluator(const std::vector<const node*>& nodes):
+        nodes_{nodes}
+    {}
+
+    node_mask operator()(const term& t) {
+        switch (t.what) {
+        case kind::all:
+            return node_mask{nodes_.size(), true};
+        case kind::has:
+            return column_(t.feature).present;
+        case kind::compare: {
+            const auto& col = column_(t.feature);
+            switch (t.cmp) {
+            case comparison::equal: return compare_(col, t.value, std::equal_to<>{});
+            case comparison::not_equal: return compare_(col, t.value, std::not_equal_to<>{});
+            case comparison::less: return compare_(col, t.value, std::less<>{});
+            case comparison::less_equal: return compare_(col, t.value, std::less_equal<>{});
+            case comparison::greater: return compare_(col, t.value, std::greater<>{});
+            case comparison::greater_equal: return compare_(col, t.value, std::greater_equal<>{});
+            }
+            break;
+        }
+        case kind::in:
+            return in_(t);
+        case kind::shift:
+            return (*this)(*t.lhs).shifted(t.offset);
+        case kind::conjunction: {
+            auto res = (*this)(*t.lhs);
+            // nothing left to narrow down
+            return res.none() ? res : res &= (*this)(*t.rhs);
+        }
+        case kind::disjunction:
+            return (*this)(*t.lhs) |= (*this)(*t.rhs);
+        case kind::negation:
+            return ~(*this)(*t.lhs);
+        }
+        throw std::logic_error{"invalid predicate term"};
+    }
+};
+
+std::vector<const node*> nodes_of(const relation& rel) {
+    std::vector<const node*> res;
+    for (auto&& n: rel) {
+        res.push_back(&n);
+    }
+    return res;
+}
+}  // namespace
+
+predicate::predicate():
+    term_{std::make_shared<const term>()}
+{}
+
+predicate predicate::has(feature_name feat) {
+    term t;
+    t.what = kind::has;
+    t.feature = feat;
+    return predicate{std::make_shared<const term>(std::move(t))};
+}
+
+predicate predicate::compare(feature_name feat, comparison cmp, std::uint64_t value) {
+    if (!detail::feature_is_integral(feat)) {
+        throw std::invalid_argument{"cannot compare non-integral feature " + to_string(feat)};
+    }
+    term t;
+    t.what = kind::compare;
+    t.feature = feat;
+    t.cmp = cmp;
+    t.value = value;
+    return predicate{std::make_shared<const term>(std::move(t))};
+}
+
+predicate predicate::in(feature_name feat, std::vector<string> values) {
+    std::sort(values.begin(), values.end());
+    term t;
+    t.what = kind::in;
+    t.feature = feat;
+    t.values = std::move(values);
+    return predicate{std::make_shared<const term>(std::move(t))};
+}
+
+predicate predicate::next(const predicate& p) {
+    term t;
+    t.what = kind::shift;
+    t.offset = 1;
+    t.lhs = p.term_;
+    return predicate{std::make_shared<const term>(std::move(t))};
+}
+
+predicate predicate::prev(const predicate& p) {
+    term t;
+    t.what = kind::shift;
+    t.offset = -1;
+    t.lhs = p.term_;
+    return predicate{std::make_shared<const term>(std::move(t))};
+}
+
+predicate operator&&(const predicate& lhs, const predicate& rhs) {
+    predicate::term t;
+    t.what = kind::conjunction;
+    t.lhs = lhs.term_;
+    t.rhs = rhs.term_;
+    return predicate{std::make_shared<const predicate::term>(std::move(t))};
+}
+
+predicate operator||(const predicate& lhs, const predicate& rhs) {
+    predicate::term t;
+    t.what = kind::disjunction;
+    t.lhs = lhs.term_;
+    t.rhs = rhs.term_;
+    return predicate{std::make_shared<const predicate::term>(std::move(t))};
+}
+
+predicate operator!(const predicate& p) {
+    predicate::term t;
+    t.what = kind::negation;
+    t.lhs = p.term_;
+    return predicate{std::make_shared<const predicate::term>(std::move(t))};
+}
+
+node_mask predicate::evaluate(const std::vector<const node*>& nodes) const {
+    return evaluator{nodes}(*term_);
+}
+
+node_mask predicate::evaluate(const relation& rel) const {
+    return evaluate(nodes_of(rel));
+}
+
+std::vector<const node*> predicate::select(const relation& rel) const {
+    const auto nodes = nodes_of(rel);
+    std::vector<const node*> res;
+    evaluate(nodes).for_each([&](std::size_t i) { res.push_back(nodes[i]); });
+    return res;
+}
+}  // namespace hrglib
@@ -2,9 +2,12 @@
 #include "hrglib/relation_name.hpp"
 #include "hrglib/error.hpp"
 #include "hrglib/graph.hpp"
+#include "hrglib/mutation_listener.hpp"
 
 #include <cassert>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace hrglib {
@@ -19,28 +22,71 @@ unique_ptr<relation> relation::default_factory::operator()(hrglib::graph& g, rel
     HANDLE_CASE(Token)
     HANDLE_CASE(Word)
     HANDLE_CASE(Syllable)
+    HANDLE_CASE(Phrase)
 #undef HANDLE_CASE
     default:
         throw error::bad_relation{rel};
     }
 }
 
+relation& relation::set_first_(node* n) {
+    if (first_ != n) {
+        if (graph_->listened_()) {
+            graph_->notify_(&detail::mutation_listener::relation_changing, *this);
+        }
+        ++sequence_version_;
+        first_ = n;
+    }
+    return *this;
+}
+
+relation& relation::set_last_(node* n) {
+    if (last_ != n) {
+        if (graph_->listened_()) {
+            graph_->notify_(&detail::mutation_listener::relation_changing, *this);
+        }
+        ++sequence_version_;
+        last_ = n;
+    }
+    return *this;
+}
+
 relation& relation::set_first(node* n) {
     if (nullptr != n && &n->relation() != this) {
-        throw error::bad_relation{n->relation_name()};
+        if (!graph_->deferred_validation_) {
+            throw error::bad_relation{n->relation_name()};
+        }
+        if (&n->graph() != graph_) {
+            throw std::invalid_argument{"relation ends must be in the same graph"};
+        }
     }
     return set_first_(n);
 }
 
 relation& relation::set_last(node* n) {
     if (nullptr != n && &n->relation() != this) {
-        throw error::bad_relation{n->relation_name()};
+        if (!graph_->deferred_validation_) {
+            throw error::bad_relation{n->relation_name()};
+        }
+        if (&n->graph() != graph_) {
+            throw std::invalid_argument{"relation ends must be in the same graph"};
+        }
     }
     return set_last_(n);
 }
 
 node& relation::create(node* in_other_relation) {
-    return **insert(graph_.node_factory()(*this, in_other_relation)).first;
+    auto& res = **insert(graph_->node_factory()(*this, in_other_relation)).first;
+    if (free_ids_.empty()) {
+        res.id_ = id_bound_++;
+    } else {
+        res.id_ = free_ids_.back();
+        free_ids_.pop_back();
+    }
+    if (graph_->listened_()) {
+        graph_->notify_(&detail::mutation_listener::node_created, res);
+    }
+    return res;
 }
 
 void relation::erase(node& n) {
@@ -48,45 +94,387 @@ void relation::erase(node& n) {
     if (this != &n.relation()) {
         throw std::invalid_argument{"node in other relation"};
     }
+    if (graph_->listened_()) {
+        graph_->notify_(&detail::mutation_listener::node_erasing, n);
+    }
     if (&n == first_) {
-        first_ = n.next();
+        set_first_(n.next());
     }
     if (&n == last_) {
-        last_ = n.prev();
+        set_last_(n.prev());
+    }
+    if (&n == tail_) {
+        tail_ = nullptr;
     }
+    const auto id = n.id_;
     std::unique_ptr<node> tmp{&n};
     try {
         base::erase(tmp);
         tmp.release();
+        free_ids_.push_back(id);
     } catch (...) {
         tmp.release();
         throw;
     }
 }
 
+std::size_t relation::erase(iterator first, iterator last) {
+    std::vector<node*> doomed;
+    for (; first.nav() && first.nav().get() != last.nav().get(); ++first) {
+        doomed.push_back(first.nav().get());
+    }
+    return erase_batch_(std::move(doomed), false);
+}
+
+std::size_t relation::erase_batch_(std::vector<node*> doomed, bool other_relations) {
+    std::unordered_set<const node*> marked(doomed.begin(), doomed.end());
+    std::unordered_map<relation*, std::vector<node*>> others;
+    if (other_relations) {
+        for (auto n: doomed) {
+            for (auto&& kv: n->relations()) {
+                if (auto& h = kv.second.get(); &h != n) {
+                    others[&h.relation()].push_back(&h);
+                }
+            }
+        }
+    }
+    // cut out each run of doomed nodes, joining its neighbours
+    for (auto start: doomed) {
+        if (start->prev_ != nullptr && marked.count(start->prev_) != 0) {
+            continue;
+        }
+        auto end = start;
+        while (end->next_ != nullptr && marked.count(end->next_) != 0) {
+            end = end->next_;
+        }
+        // while the run is still linked, move the child spans of parents to the nearest
+        // surviving siblings as single erasures do, first ends forward and last ends back
+        for (auto n = start;; n = n->next_) {
+            if (auto p = n->parent_; p != nullptr && p->first_child_ == n) {
+                const bool only = p->last_child_ == n;
+                p->write_(p->first_child_, pivot::first_child, only ? nullptr : n->next_);
+                if (only) {
+                    p->write_(p->last_child_, pivot::last_child, nullptr);
+                }
+            }
+            if (n == end) {
+                break;
+            }
+        }
+        for (auto n = end;; n = n->prev_) {
+            if (auto p = n->parent_; p != nullptr && p->last_child_ == n) {
+                p->write_(p->last_child_, pivot::last_child, n->prev_);
+            }
+            if (n == start) {
+                break;
+            }
+        }
+        const auto before = start->prev_;
+        const auto after = end->next_;
+        if (start == first_) {
+            set_first_(after);
+        }
+        if (end == last_) {
+            set_last_(before);
+        }
+        if (end == tail_) {
+            tail_ = nullptr;
+        }
+        if (before != nullptr) {
+            start->write_(start->prev_, pivot::prev, nullptr);
+            before->write_(before->next_, pivot::next, after);
+        }
+        if (after != nullptr) {
+            end->write_(end->next_, pivot::next, nullptr);
+            after->write_(after->prev_, pivot::prev, before);
+        }
+    }
+    // large batches are released in one sweep over the handles instead of a lookup each
+    if (doomed.size() * 4 < base::size()) {
+        for (auto n: doomed) {
+            erase(*n);
+        }
+    } else {
+        free_ids_.reserve(free_ids_.size() + doomed.size());
+        for (auto it = base::begin(); it != base::end();) {
+            auto& n = **it;
+            if (marked.count(&n) == 0) {
+                ++it;
+                continue;
+            }
+            if (graph_->listened_()) {
+                graph_->notify_(&detail::mutation_listener::node_erasing, n);
+            }
+            if (&n == first_) {
+                set_first_(n.next());
+            }
+            if (&n == last_) {
+                set_last_(n.prev());
+            }
+            if (&n == tail_) {
+                tail_ = nullptr;
+            }
+            free_ids_.push_back(n.id_);
+            it = base::erase(it);
+        }
+    }
+    for (auto&& kv: others) {
+        kv.first->erase_batch_(std::move(kv.second), false);
+    }
+    return doomed.size();
+}
+
+void relation::splice(node* position, node& first, node& last, bool children) {
+    for (auto n: {position, &first, &last}) {
+        if (nullptr != n && &n->relation() != this) {
+            throw error::bad_relation{n->relation_name()};
+        }
+    }
+    // the node the run goes after
+    node* before = nullptr;
+    if (position != nullptr) {
+        before = position->prev_;
+    } else if (last_ != nullptr) {
+        before = last_;
+    } else if (first_ != nullptr) {
+        before = tail_ != nullptr && tail_version_ == sequence_version_ ? tail_ : &node::last_(*first_);
+    }
+    if (position == &first || before == &last) {
+        return;
+    }
+
+    // parents keeping other children behind lose the moved ones
+    const auto p1 = first.parent_;
+    const auto pk = last.parent_;
+    const bool partial1 = p1 != nullptr
+            && (p1->first_child_ != &first || (p1 == pk && p1->last_child_ != &last));
+    const bool partialk = pk != nullptr
+            && (pk->last_child_ != &last || (p1 == pk && pk->first_child_ != &first));
+    const auto partial = [&](node* p) { return p != nullptr && ((partial1 && p == p1) || (partialk && p == pk)); };
+    node* adopter = nullptr;
+    bool adopt_first = false;
+    bool adopt_last = false;
+    if (before != nullptr && position != nullptr && before->parent_ == position->parent_) {
+        adopter = before->parent_;
+    } else if (position != nullptr && partial(position->parent_) && position->parent_->first_child_ == position) {
+        adopter = position->parent_;
+        adopt_first = true;
+    } else if (before != nullptr && partial(before->parent_) && before->parent_->last_child_ == before) {
+        adopter = before->parent_;
+        adopt_last = true;
+    }
+    if (adopter != nullptr && !(p1 == pk && partial1)) {
+        for (auto n = &first; ; n = n->next_) {
+            const auto p = n->parent_;
+            if (p != nullptr && !(partial1 && p == p1) && !(partialk && p == pk)) {
+                throw std::invalid_argument{"splice would mix children of different parents"};
+            }
+            if (n == &last) {
+                break;
+            }
+        }
+    }
+    if (children) {
+        splice_children_(before, position, first, last);
+    }
+
+    const auto detach = [&](node* parent, bool from_first) {
+        if (from_first) {
+            for (auto n = &first; n != nullptr && n->parent_ == parent; n = n == &last ? nullptr : n->next_) {
+                n->write_(n->parent_, pivot::parent, nullptr);
+            }
+        } else {
+            for (auto n = &last; n != nullptr && n->parent_ == parent; n = n == &first ? nullptr : n->prev_) {
+                n->write_(n->parent_, pivot::parent, nullptr);
+            }
+        }
+        if (parent->first_child_ == &first || !from_first) {
+            const auto next = last.next_ != nullptr && last.next_->parent_ == parent ? last.next_ : nullptr;
+            parent->write_(parent->first_child_, pivot::first_child, next);
+        }
+        if (parent->last_child_ == &last || from_first) {
+            const auto prev = first.prev_ != nullptr && first.prev_->parent_ == parent ? first.prev_ : nullptr;
+            parent->write_(parent->last_child_, pivot::last_child, prev);
+        }
+    };
+    if (partial1) {
+        detach(p1, p1 != pk);
+    }
+    if (partialk && pk != p1) {
+        detach(pk, false);
+    }
+
+    // cut the run out, joining its neighbours
+    const auto prev = first.prev_;
+    const auto next = last.next_;
+    if (&first == first_) {
+        set_first_(next);
+    }
+    if (&last == last_) {
+        set_last_(prev);
+    }
+    if (prev != nullptr) {
+        first.write_(first.prev_, pivot::prev, nullptr);
+        prev->write_(prev->next_, pivot::next, next);
+    }
+    if (next != nullptr) {
+        last.write_(last.next_, pivot::next, nullptr);
+        next->write_(next->prev_, pivot::prev, prev);
+    }
+
+    // and put it in between the new ones
+    if (before != nullptr) {
+        before->write_(before->next_, pivot::next, &first);
+        first.write_(first.prev_, pivot::prev, before);
+    } else {
+        set_first_(&first);
+    }
+    if (position != nullptr) {
+        position->write_(position->prev_, pivot::prev, &last);
+        last.write_(last.next_, pivot::next, position);
+    } else if (last_ == before) {
+        set_last_(&last);
+    }
+    if (adopter != nullptr) {
+        for (auto n = &first; ; n = n->next_) {
+            n->write_(n->parent_, pivot::parent, adopter);
+            if (n == &last) {
+                break;
+            }
+        }
+        if (adopt_first) {
+            adopter->write_(adopter->first_child_, pivot::first_child, &first);
+        }
+        if (adopt_last) {
+            adopter->write_(adopter->last_child_, pivot::last_child, &last);
+        }
+    }
+}
+
+void relation::splice_children_(node* before, node* position, node& first, node& last) {
+    node* child_first = nullptr;
+    for (auto n = &first; child_first == nullptr; n = n->next_) {
+        child_first = n->first_child_;
+        if (n == &last) {
+            break;
+        }
+    }
+    node* child_last = nullptr;
+    for (auto n = &last; child_last == nullptr; n = n->prev_) {
+        child_last = n->last_child_;
+        if (n == &first) {
+            break;
+        }
+    }
+    if (child_first == nullptr || child_last == nullptr
+            || &child_first->relation() != &child_last->relation()) {
+        return;
+    }
+    // the children go next to the children of the new neighbours of the run
+    auto& rel = child_first->relation();
+    node* to = nullptr;
+    if (before != nullptr && before->last_child_ != nullptr) {
+        to = before->last_child_->next_;
+    } else if (position != nullptr && position->first_child_ != nullptr) {
+        to = position->first_child_;
+    } else if (before == nullptr) {
+        to = rel.first_;
+    } else if (position != nullptr) {
+        throw std::invalid_argument{"splice can't place children between nodes having none"};
+    }
+    rel.splice(to, *child_first, *child_last, true);
+}
+
+void relation::absorb_(relation& other, std::vector<node*>& moved) {
+    base::reserve(base::size() + other.base::size());
+    moved.reserve(moved.size() + other.base::size());
+    while (!other.base::empty()) {
+        auto handle = other.base::extract(other.base::begin());
+        auto& n = *handle.value();
+        n.rel_ = this;
+        if (free_ids_.empty()) {
+            n.id_ = id_bound_++;
+        } else {
+            n.id_ = free_ids_.back();
+            free_ids_.pop_back();
+        }
+        base::insert(std::move(handle));
+        moved.push_back(&n);
+    }
+    other.free_ids_.clear();
+    other.id_bound_ = 0;
+}
+
+void relation::join_(relation& other) {
+    if (other.first_ != nullptr) {
+        node* end = last_;
+        if (end == nullptr && first_ != nullptr) {
+            end = tail_ != nullptr && tail_version_ == sequence_version_ ? tail_ : &node::last_(*first_);
+        }
+        if (end != nullptr) {
+            end->write_(end->next_, pivot::next, other.first_);
+            other.first_->write_(other.first_->prev_, pivot::prev, end);
+        } else {
+            set_first_(other.first_);
+        }
+        // open relation stays open
+        if (last_ != nullptr || end == nullptr) {
+            set_last_(other.last_);
+        }
+    }
+    other.first_ = nullptr;
+    other.last_ = nullptr;
+    other.tail_ = nullptr;
+    ++other.sequence_version_;
+}
+
 node& relation::append(node* in_other_relation) {
     auto& res = create(in_other_relation);
     if (last_ != nullptr) {
         last_->set_next_(&res);
-        last_ = &res;
+        set_last_(&res);
     } else if (first_ != nullptr) {
-        // open relation
-        node::last_(*first_).set_next_(&res);
+        // open relation; the tail is reused unless the sequence changed in other ways
+        auto& tail = tail_ != nullptr && tail_version_ == sequence_version_ ? *tail_ : node::last_(*first_);
+        tail.set_next_(&res);
+        tail_ = &res;
+        tail_version_ = sequence_version_;
     } else {
         // first connected node
-        first_ = (last_ = &res);
+        set_first_(&res).set_last_(&res);
     }
     return res;
 }
 
+relation_span<node> relation::append_bulk(std::size_t count) {
+    if (count == 0) {
+        return {end(), end()};
+    }
+    base::reserve(base::size() + count);
+    auto& first = append();
+    auto* last = &first;
+    for (std::size_t i = 1; i < count; ++i) {
+        auto& n = create();
+        last->set_next_(&n);
+        last = &n;
+    }
+    if (last_ != nullptr) {
+        set_last_(last);
+    } else {
+        tail_ = last;
+        tail_version_ = sequence_version_;
+    }
+    return {iterator{first}, end()};
+}
+
 node& relation::prepend(node* in_other_relation) {
     auto& res = create(in_other_relation);
     if (first_ != nullptr) {
         first_->set_prev_(&res);
-        first_ = &res;
+        set_first_(&res);
     } else {
         assert(last_ == nullptr);
-        first_ = (last_ = &res);
+        set_first_(&res).set_last_(&res);
     }
     return res;
 }
@@ -0,0 +1,185 @@
+#include "hrglib/rollup.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_traits.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+
+#include "feature_codec.hpp"
+#include "graph_access.hpp"
+
+#include <stdexcept>
+
+namespace hrglib {
+rollup::rollup(graph& g, rollup_op op, relation_name ancestor, relation_name descendant,
+        optional<feature_name> feat):
+    graph_{g},
+    op_{op},
+    ancestor_{ancestor},
+    descendant_{descendant},
+    feature_{feat},
+    depth_{hierarchy_distance(descendant, ancestor)}
+{
+    if (depth_ <= 0) {
+        throw std::invalid_argument{"rollup ancestor relation " + to_string(ancestor)
+                + " is not above " + to_string(descendant)};
+    }
+    if (op != rollup_op::count && !feat) {
+        throw std::invalid_argument{"rollup needs feature to aggregate"};
+    }
+    if (feat && !detail::feature_is_integral(*feat)) {
+        throw std::invalid_argument{"rollup of non-integral feature " + to_string(*feat)};
+    }
+    if (auto r = g.get(descendant)) {
+        r->for_each_node([this](const node& n) { pending_.insert(&n); });
+    }
+    detail::graph_access::add_listener(g, *this);
+}
+
+rollup::~rollup() {
+    detail::graph_access::remove_listener(graph_, *this);
+}
+
+void rollup::retract_(const node& d) {
+    pending_.insert(&d);
+    auto it = contributions_.find(&d);
+    if (it == contributions_.end()) {
+        return;
+    }
+    const auto& c = it->second;
+    for (auto x: c.chain) {
+        if (auto t = through_.find(x); t != through_.end()) {
+            t->second.erase(&d);
+            if (t->second.empty()) {
+                through_.erase(t);
+            }
+        }
+    }
+    if (c.ancestor != nullptr) {
+        auto a = aggregates_.find(c.ancestor);
+        if (--a->second.count == 0) {
+            aggregates_.erase(a);
+        } else if (c.value) {
+            a->second.sum -= *c.value;
+            if (auto v = a->second.values.find(*c.value); v != a->second.values.end()) {
+                a->second.values.erase(v);
+            }
+        }
+    }
+    contributions_.erase(it);
+}
+
+void rollup::retract_through_(const node& x) {
+    if (auto t = through_.find(&x); t != through_.end()) {
+        const auto ds = t->second;
+        for (auto d: ds) {
+            retract_(*d);
+        }
+    }
+}
+
+void rollup::resolve_(const node& d) {
+    auto& c = contributions_[&d];
+    auto x = d.parent().get();
+    // intermediate relations are those between descendant and ancestor; the nodes are
+    // tracked even if the chain is broken, so that linking it up later gets noticed
+    for (int hop = 1; x != nullptr && hop < depth_; ++hop) {
+        const auto dist = hierarchy_distance(descendant_, x->relation_name());
+        if (dist <= 0 || dist >= depth_) {
+            x = nullptr;
+            break;
+        }
+        c.chain.push_back(x);
+        through_[x].insert(&d);
+        x = x->parent().get();
+    }
+    if (x == nullptr || x->relation_name() != ancestor_) {
+        return;
+    }
+    c.chain.push_back(x);
+    through_[x].insert(&d);
+    c.ancestor = x;
+    if (feature_) {
+        if (auto v = d.features().get(*feature_)) {
+            c.value = detail::feature_value_to_uint(*feature_, *v);
+        }
+    }
+    auto& a = aggregates_[x];
+    ++a.count;
+    if (c.value) {
+        a.sum += *c.value;
+        if (op_ == rollup_op::min || op_ == rollup_op::max) {
+            a.values.insert(*c.value);
+        }
+    }
+}
+
+void rollup::flush_() {
+    for (auto d: pending_) {
+        resolve_(*d);
+    }
+    pending_.clear();
+}
+
+optional<rollup::value_type> rollup::get(const node& n) {
+    if (n.relation_name() != ancestor_) {
+        throw error::bad_relation{n.relation_name()};
+    }
+    flush_();
+    const auto a = map_find(aggregates_, &n);
+    switch (op_) {
+    case rollup_op::count:
+        return a ? a->count : 0;
+    case rollup_op::sum:
+        return a ? a->sum : 0;
+    case rollup_op::min:
+        if (a && !a->values.empty()) {
+            return *a->values.begin();
+        }
+        return {};
+    case rollup_op::max:
+        if (a && !a->values.empty()) {
+            return *a->values.rbegin();
+        }
+        return {};
+    }
+    return {};
+}
+
+void rollup::node_created(node& n) {
+    if (n.relation_name() == descendant_) {
+        pending_.insert(&n);
+    }
+}
+
+void rollup::node_erasing(node& n) {
+    if (n.relation_name() == descendant_) {
+        retract_(n);
+        pending_.erase(&n);
+    } else {
+        // descendants get resolved again once their links to n are cleared
+        retract_through_(n);
+    }
+}
+
+void rollup::link_changing(node& n, pivot p) {
+    if (p != pivot::parent) {
+        return;
+    }
+    if (n.relation_name() == descendant_) {
+        retract_(n);
+    } else {
+        retract_through_(n);
+    }
+}
+
+void rollup::feature_changing(node& n, feature_name feat) {
+    if (feature_ == feat) {
+        if (auto d = n.as(descendant_)) {
+            retract_(*d);
+        }
+    }
+}
+}  // namespace hrglib
@@ -0,0 +1,27 @@
+#include "hrglib/sequence_relation.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/token.hpp"
+
+#include <algorithm>
+
+namespace hrglib {
+unique_ptr<relation> sequence_relation_factory::operator()(hrglib::graph& g, relation_name rel) const {
+    if (std::find(sequences.begin(), sequences.end(), rel) == sequences.end()) {
+        return relation::default_factory{}(g, rel);
+    }
+    switch (rel) {
+#define HANDLE_CASE(rel) \
+    case R:: rel : \
+        return unique_ptr<relation>{new sequence_relation_<R:: rel> {g}};
+
+    HANDLE_CASE(Token)
+    HANDLE_CASE(Word)
+    HANDLE_CASE(Syllable)
+    HANDLE_CASE(Phrase)
+#undef HANDLE_CASE
+    default:
+        throw error::bad_relation{rel};
+    }
+}
+}  // namespace hrglib
@@ -0,0 +1,406 @@
+#include "hrglib/shared_graph.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+
+#include "feature_codec.hpp"
+#include "feature_entry.hpp"
+#include "graph_access.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bitset>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hrglib {
+namespace {
+namespace shm = detail::shm;
+
+constexpr char magic[8] = {'h', 'r', 'g', 'l', 'i', 'b', 's', 'g'};
+constexpr std::uint32_t version = 1;
+
+[[noreturn]] void throw_errno(const char* what) {
+    throw std::system_error{errno, std::generic_category(), what};
+}
+
+//! Owns file descriptor until the mapping is established.
+struct fd_guard {
+    int fd;
+    ~fd_guard() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+std::size_t align_up(std::size_t n, std::size_t a) noexcept {
+    return (n + a - 1) / a * a;
+}
+
+std::uint32_t to_index(std::size_t i) {
+    if (i >= shm::none) {
+        throw error::bad_handoff{"graph too large for shared image"};
+    }
+    return static_cast<std::uint32_t>(i);
+}
+
+//! Whether table of @p count entries of type T at offset @p off fits in image of @p size.
+template<typename T>
+bool fits(std::uint64_t off, std::uint64_t count, std::size_t size) noexcept {
+    return off % alignof(T) == 0 && off <= size && count <= (size - off) / sizeof(T);
+}
+
+/**
+ * Whether all the indices and offsets of the image stay within its @p size, so that it can
+ * be navigated without further checks. Rings of shared contents must be cycles of handles
+ * in distinct relations, which holds if they form a permutation and no cycle repeats
+ * a relation.
+ */
+bool well_formed(const shm::header& img, std::size_t size) {
+    const auto count = img.node_count;
+    const auto valid = [count](std::uint32_t i) { return i == shm::none || i < count; };
+    if (!fits<shm::node_entry>(img.nodes, count, size)
+            || !fits<shm::feature_entry>(img.features, img.feature_count, size)
+            || img.strings > size) {
+        return false;
+    }
+    for (auto&& re: img.relations) {
+        if (!valid(re.first) || !valid(re.last) || re.size > count) {
+            return false;
+        }
+    }
+    for (std::uint32_t f = 0; f < img.feature_count; ++f) {
+        const auto& fe = img.feature(f);
+        if (fe.name >= static_cast<std::uint32_t>(feature_name::COUNT)) {
+            return false;
+        }
+        const auto feat = static_cast<feature_name>(fe.name);
+        if (!detail::feature_is_integral(feat)
+                && (detail::feature_entry::for_(feat).type != typeid(string)
+                        || fe.value > size - img.strings || fe.length > size - img.strings - fe.value)) {
+            return false;
+        }
+    }
+    std::vector<bool> pointed(count, false);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const auto& ne = img.node(i);
+        if (ne.relation >= static_cast<std::uint32_t>(relation_name::COUNT)
+                || ne.same_contents >= count || pointed[ne.same_contents]
+                || ne.features_begin > ne.features_end || ne.features_end > img.feature_count) {
+            return false;
+        }
+        pointed[ne.same_contents] = true;
+        for (auto l: ne.links) {
+            if (!valid(l)) {
+                return false;
+            }
+        }
+    }
+    std::vector<bool> visited(count, false);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::bitset<static_cast<std::size_t>(relation_name::COUNT)> relations;
+        for (auto j = i; !visited[j]; j = img.node(j).same_contents) {
+            visited[j] = true;
+            if (relations.test(img.node(j).relation)) {
+                return false;
+            }
+            relations.set(img.node(j).relation);
+        }
+    }
+    return true;
+}
+
+//! Flattened graph with node and feature tables, ready to be copied into the segment.
+struct image_builder {
+    std::vector<shm::node_entry> nodes;
+    std::vector<shm::feature_entry> features;
+    string strings;
+    shm::relation_entry relations[static_cast<std::size_t>(relation_name::COUNT)] = {};
+
+    explicit image_builder(const graph& g) {
+        std::unordered_map<const node*, std::uint32_t> index;
+        std::vector<const node*> order;
+        g.for_each_relation([&](const relation& r) {
+            auto& re = relations[static_cast<std::size_t>(r.name())];
+            re.present = 1;
+            const auto start = order.size();
+            auto add = [&](const node* n) {
+                if (index.emplace(n, to_index(order.size())).second) {
+                    order.push_back(n);
+                }
+            };
+            for (auto n = r.first().get(); n != nullptr && index.count(n) == 0; n = n->next().get()) {
+                add(n);
+            }
+            r.for_each_node([&](const node& n) { add(&n); });
+            re.size = to_index(order.size() - start);
+        });
+        auto index_of = [&](const node* n) {
+            return n != nullptr ? index.at(n) : shm::none;
+        };
+        g.for_each_relation([&](const relation& r) {
+            auto& re = relations[static_cast<std::size_t>(r.name())];
+            re.first = index_of(r.first().get());
+            re.last = index_of(r.last().get());
+        });
+
+        nodes.resize(order.size());
+        // first handle of given contents, whose features and ring the others join
+        std::unordered_map<const hrglib::features*, std::uint32_t> contents;
+        for (std::uint32_t i = 0; i < order.size(); ++i) {
+            const auto& n = *order[i];
+            auto& ne = nodes[i];
+            ne.relation = static_cast<std::uint32_t>(n.relation_name());
+            for (std::size_t p = 0; p < static_cast<std::size_t>(pivot::COUNT); ++p) {
+                ne.links[p] = index_of(n.link(static_cast<pivot>(p)).get());
+            }
+            const auto& feats = n.features();
+            if (auto first = map_find(contents, &feats)) {
+                auto& fe = nodes[*first];
+                ne.features_begin = fe.features_begin;
+                ne.features_end = fe.features_end;
+                ne.same_contents = fe.same_contents;
+                fe.same_contents = i;
+                continue;
+            }
+            contents.emplace(&feats, i);
+            ne.same_contents = i;
+            ne.features_begin = to_index(features.size());
+            for (auto&& kv: feats) {
+                shm::feature_entry fe{static_cast<std::uint32_t>(kv.first), 0, 0};
+                if (detail::feature_is_integral(kv.first)) {
+                    fe.value = detail::feature_value_to_uint(kv.first, kv.second);
+                } else if (detail::feature_entry::for_(kv.first).type == typeid(string)) {
+                    const auto& s = any_cast<const string&>(kv.second);
+                    fe.value = strings.size();
+                    fe.length = to_index(s.size());
+                    strings += s;
+                } else {
+                    throw error::bad_handoff{"feature " + to_string(kv.first) + " can't be shared"};
+                }
+                features.push_back(fe);
+            }
+            ne.features_end = to_index(features.size());
+        }
+    }
+};
+}  // namespace
+
+shared_graph::shared_graph(const shm::header* img, std::size_t size, string name, bool publisher) noexcept:
+    img_{img},
+    size_{size},
+    name_{std::move(name)},
+    publisher_{publisher}
+{}
+
+shared_graph::shared_graph(shared_graph&& other) noexcept:
+    img_{std::exchange(other.img_, nullptr)},
+    size_{std::exchange(other.size_, 0)},
+    name_{std::move(other.name_)},
+    publisher_{other.publisher_}
+{}
+
+shared_graph& shared_graph::operator=(shared_graph&& other) noexcept {
+    if (this != &other) {
+        release_();
+        img_ = std::exchange(other.img_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        name_ = std::move(other.name_);
+        publisher_ = other.publisher_;
+    }
+    return *this;
+}
+
+shared_graph::~shared_graph() {
+    release_();
+}
+
+void shared_graph::release_() noexcept {
+    if (img_ == nullptr) {
+        return;
+    }
+    if (publisher_) {
+        auto& state = const_cast<shm::header*>(img_)->state;
+        auto expected = static_cast<std::uint32_t>(shm::state::published);
+        // revoke image nobody took over; consumer removes the name otherwise
+        if (state.compare_exchange_strong(expected, static_cast<std::uint32_t>(shm::state::closed))) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+    ::munmap(const_cast<shm::header*>(img_), size_);
+    img_ = nullptr;
+    size_ = 0;
+}
+
+shared_graph shared_graph::publish(const hrglib::graph& g, const string& name) {
+    const image_builder b{g};
+    const auto nodes_off = align_up(sizeof(shm::header), alignof(shm::node_entry));
+    const auto features_off = align_up(nodes_off + b.nodes.size() * sizeof(shm::node_entry), alignof(shm::feature_entry));
+    const auto strings_off = features_off + b.features.size() * sizeof(shm::feature_entry);
+    const auto size = strings_off + b.strings.size();
+
+    fd_guard fd{::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)};
+    if (fd.fd < 0) {
+        throw_errno("shm_open");
+    }
+    auto unlink_on_error = [&name]() { ::shm_unlink(name.c_str()); };
+    if (::ftruncate(fd.fd, static_cast<off_t>(size)) != 0) {
+        const auto err = errno;
+        unlink_on_error();
+        errno = err;
+        throw_errno("ftruncate");
+    }
+    auto mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.fd, 0);
+    if (mem == MAP_FAILED) {
+        const auto err = errno;
+        unlink_on_error();
+        errno = err;
+        throw_errno("mmap");
+    }
+    auto img = new (mem) shm::header{};
+    std::memcpy(img->magic, magic, sizeof(magic));
+    img->version = version;
+    img->size = size;
+    img->node_count = to_index(b.nodes.size());
+    img->feature_count = to_index(b.features.size());
+    img->nodes = nodes_off;
+    img->features = features_off;
+    img->strings = strings_off;
+    std::memcpy(img->relations, b.relations, sizeof(b.relations));
+    auto base = static_cast<char*>(mem);
+    std::memcpy(base + nodes_off, b.nodes.data(), b.nodes.size() * sizeof(shm::node_entry));
+    std::memcpy(base + features_off, b.features.data(), b.features.size() * sizeof(shm::feature_entry));
+    std::memcpy(base + strings_off, b.strings.data(), b.strings.size());
+    img->state.store(static_cast<std::uint32_t>(shm::state::published), std::memory_order_release);
+    return shared_graph{img, size, name, true};
+}
+
+shared_graph shared_graph::acquire(const string& name) {
+    fd_guard fd{::shm_open(name.c_str(), O_RDWR, 0)};
+    if (fd.fd < 0) {
+        throw_errno("shm_open");
+    }
+    struct stat st;
+    if (::fstat(fd.fd, &st) != 0) {
+        throw_errno("fstat");
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    if (size < sizeof(shm::header)) {
+        throw error::bad_handoff{"shared graph image too small"};
+    }
+    // mapped writable only for the sake of state word
+    auto mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.fd, 0);
+    if (mem == MAP_FAILED) {
+        throw_errno("mmap");
+    }
+    auto img = static_cast<shm::header*>(mem);
+    auto expected = static_cast<std::uint32_t>(shm::state::published);
+    if (std::memcmp(img->magic, magic, sizeof(magic)) != 0 || img->version != version || img->size != size) {
+        ::munmap(mem, size);
+        throw error::bad_handoff{"malformed shared graph image"};
+    }
+    if (!img->state.compare_exchange_strong(expected, static_cast<std::uint32_t>(shm::state::acquired),
+            std::memory_order_acq_rel)) {
+        ::munmap(mem, size);
+        throw error::bad_handoff{"shared graph " + name + " was already acquired or revoked"};
+    }
+    ::shm_unlink(name.c_str());
+    // the publisher may still write to the segment, so the check and all later reads
+    // go to a private copy
+    auto copy = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (copy == MAP_FAILED) {
+        const auto err = errno;
+        ::munmap(mem, size);
+        errno = err;
+        throw_errno("mmap");
+    }
+    std::memcpy(copy, mem, size);
+    ::munmap(mem, size);
+    img = static_cast<shm::header*>(copy);
+    // the tables are complete only once published, and are not trusted even then
+    if (!well_formed(*img, size)) {
+        ::munmap(copy, size);
+        throw error::bad_handoff{"malformed shared graph image"};
+    }
+    ::mprotect(copy, size, PROT_READ);
+    return shared_graph{img, size, name, false};
+}
+
+bool shared_graph::handed_off() const noexcept {
+    return publisher_ && img_ != nullptr
+            && img_->state.load(std::memory_order_acquire) == static_cast<std::uint32_t>(shm::state::acquired);
+}
+
+bool shared_graph::has(relation_name rel) const noexcept {
+    return img_->relations[static_cast<std::size_t>(rel)].present != 0;
+}
+
+std::size_t shared_graph::size(relation_name rel) const noexcept {
+    return img_->relations[static_cast<std::size_t>(rel)].size;
+}
+
+optional<shared_node> shared_graph::first(relation_name rel) const noexcept {
+    const auto i = img_->relations[static_cast<std::size_t>(rel)].first;
+    return i != shm::none && has(rel) ? optional<shared_node>{shared_node{img_, i}} : nullopt;
+}
+
+optional<shared_node> shared_graph::last(relation_name rel) const noexcept {
+    const auto i = img_->relations[static_cast<std::size_t>(rel)].last;
+    return i != shm::none && has(rel) ? optional<shared_node>{shared_node{img_, i}} : nullopt;
+}
+
+graph shared_graph::to_graph(optional<hrglib::graph::builder> b) const {
+    auto g = b.value_or(graph::builder{}).build();
+    std::vector<node*> nodes(img_->node_count, nullptr);
+    for (std::uint32_t i = 0; i < img_->node_count; ++i) {
+        const auto& ne = img_->node(i);
+        auto& r = g[static_cast<relation_name>(ne.relation)];
+        // handles are created in image order; the ring leads to any earlier handle of the contents
+        node* shares = nullptr;
+        for (auto j = ne.same_contents; j != i && shares == nullptr; j = img_->node(j).same_contents) {
+            shares = nodes[j];
+        }
+        auto& n = r.create(shares);
+        nodes[i] = &n;
+        if (shares != nullptr) {
+            continue;
+        }
+        for (auto f = ne.features_begin; f != ne.features_end; ++f) {
+            const auto& fe = img_->feature(f);
+            const auto feat = static_cast<feature_name>(fe.name);
+            detail::graph_access::put_feature(n.features(), feat, detail::feature_is_integral(feat)
+                    ? detail::feature_value_from_uint(feat, fe.value)
+                    : any{string{img_->string(fe)}});
+        }
+    }
+    for (std::uint32_t i = 0; i < img_->node_count; ++i) {
+        const auto& ne = img_->node(i);
+        for (std::size_t p = 0; p < static_cast<std::size_t>(pivot::COUNT); ++p) {
+            if (ne.links[p] != shm::none) {
+                detail::graph_access::assign_link(*nodes[i], static_cast<pivot>(p), nodes[ne.links[p]]);
+            }
+        }
+    }
+    for (std::size_t rel = 0; rel < static_cast<std::size_t>(relation_name::COUNT); ++rel) {
+        if (const auto& re = img_->relations[rel]; re.present != 0) {
+            auto& r = g[static_cast<relation_name>(rel)];
+            r.set_first(re.first != shm::none ? nodes[re.first] : nullptr);
+            r.set_last(re.last != shm::none ? nodes[re.last] : nullptr);
+        }
+    }
+    return g;
+}
+}  // namespace hrglib
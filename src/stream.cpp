@@ -0,0 +1,176 @@
+#include "yaml-cpp_config.hpp"
+#include "hrglib/stream.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/map_find.hpp"
+
+#include "delta.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+namespace hrglib {
+struct stream_writer::chunk_ {
+    detail::delta delta;
+    //! Position of links update of given node id in `delta.linked`.
+    std::unordered_map<std::size_t, std::size_t> links;
+    std::unordered_set<relation_name> relations;
+
+    void link(std::size_t id, pivot p, std::size_t target) {
+        auto [it, inserted] = links.try_emplace(id, delta.linked.size());
+        if (inserted) {
+            delta.linked.push_back({id, {}});
+        }
+        auto& ls = delta.linked[it->second].links;
+        auto l = std::find_if(ls.begin(), ls.end(), [p](auto&& l) { return l.which == p; });
+        if (l != ls.end()) {
+            l->target = target;
+        } else {
+            ls.push_back({p, target});
+        }
+    }
+};
+
+stream_writer::stream_writer(const hrglib::graph& g, std::ostream& os, stream_format fmt):
+    graph_{g},
+    os_{os},
+    format_{fmt}
+{}
+
+std::size_t stream_writer::id(const node& n) const {
+    if (auto id = map_find(ids_, &n)) {
+        return *id;
+    } else {
+        throw error::bad_node{"node not written to stream yet"};
+    }
+}
+
+void stream_writer::write_node_(chunk_& c, const node& n) {
+    const auto id = ids_.size();
+    ids_.emplace(&n, id);
+    c.relations.insert(n.relation_name());
+    const auto& feats = n.features();
+    if (auto shares = map_find(contents_, &feats)) {
+        c.delta.created.push_back({id, n.relation_name(), *shares});
+    } else {
+        c.delta.created.push_back({id, n.relation_name(), nullopt});
+        contents_.emplace(&feats, id);
+        if (!feats.empty()) {
+            c.delta.updated.push_back({id, feats, {}});
+        }
+    }
+    for (std::size_t i = 0; i < static_cast<std::size_t>(pivot::COUNT); ++i) {
+        const auto p = static_cast<pivot>(i);
+        if (auto target = n.link(p)) {
+            if (auto tid = map_find(ids_, target.get())) {
+                c.link(id, p, *tid);
+                // final nodes still get linked to their successors, like the watermark
+                // to the node appended after it, or the parent to its newly added last child
+                for (std::size_t j = 0; j < static_cast<std::size_t>(pivot::COUNT); ++j) {
+                    const auto q = static_cast<pivot>(j);
+                    if (target->link(q).get() == &n) {
+                        c.link(*tid, q, id);
+                    }
+                }
+            } else {
+                pending_.emplace(target.get(), std::make_pair(&n, p));
+            }
+        }
+    }
+    const auto [first, last] = pending_.equal_range(&n);
+    for (auto it = first; it != last; ++it) {
+        c.link(ids_.at(it->second.first), it->second.second, id);
+    }
+    pending_.erase(first, last);
+}
+
+bool stream_writer::write_prefix_(chunk_& c, const node& watermark) {
+    if (ids_.count(&watermark) != 0) {
+        return true;
+    }
+    const auto& r = watermark.relation();
+    auto cursor = map_find(cursors_, r.name());
+    auto start = cursor ? (*cursor)->next().get() : r.first().get();
+    std::vector<const node*> run;
+    for (auto n = start; n != &watermark; n = n->next().get()) {
+        if (n == nullptr) {
+            return false;
+        }
+        run.push_back(n);
+    }
+    run.push_back(&watermark);
+    for (auto n: run) {
+        write_node_(c, *n);
+    }
+    cursors_[r.name()] = &watermark;
+    if (auto child = watermark.last_child()) {
+        // subtree in the child relation is final as well; failure to reach it means
+        // irregular hierarchy which is simply written out later
+        write_prefix_(c, *child);
+    }
+    return true;
+}
+
+void stream_writer::write_rest_(chunk_& c, const relation& r) {
+    auto cursor = map_find(cursors_, r.name());
+    auto n = cursor ? (*cursor)->next().get() : r.first().get();
+    for (; n != nullptr && ids_.count(n) == 0; n = n->next().get()) {
+        write_node_(c, *n);
+        cursors_[r.name()] = n;
+    }
+    r.for_each_node([&](const node& loose) {
+        if (ids_.count(&loose) == 0) {
+            write_node_(c, loose);
+        }
+    });
+}
+
+void stream_writer::write_chunk_(chunk_& c, bool final) {
+    auto id_of = [this](const node* n) -> optional<std::size_t> {
+        if (n != nullptr) {
+            if (auto id = map_find(ids_, n)) {
+                return *id;
+            }
+        }
+        return nullopt;
+    };
+    for (auto rel: c.relations) {
+        const auto& r = *graph_.get(rel);
+        const auto last = final ? r.last().get() : cursors_.at(rel);
+        c.delta.bounds.push_back({rel, id_of(r.first().get()), id_of(last)});
+    }
+    detail::write_delta(os_, c.delta, format_);
+}
+
+stream_writer& stream_writer::finalize(const node& watermark) {
+    if (closed_) {
+        throw std::logic_error{"stream_writer already closed"};
+    }
+    chunk_ c;
+    if (!write_prefix_(c, watermark)) {
+        throw error::bad_node{"watermark not reachable from last finalized node"};
+    }
+    if (!c.delta.empty()) {
+        write_chunk_(c, false);
+    }
+    return *this;
+}
+
+void stream_writer::close() {
+    if (closed_) {
+        throw std::logic_error{"stream_writer already closed"};
+    }
+    chunk_ c;
+    graph_.for_each_relation([&](const relation& r) {
+        write_rest_(c, r);
+        c.relations.insert(r.name());
+    });
+    closed_ = true;
+    write_chunk_(c, true);
+}
+}  // namespace hrglib
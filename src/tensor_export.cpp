@@ -0,0 +1,115 @@
+#include "hrglib/tensor_export.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_traits.hpp"
+#include "hrglib/features.hpp"
+
+#include "feature_codec.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace hrglib {
+tensor_export::tensor_export(const hrglib::relation& rel, std::vector<feature_name> feats):
+    relation_{rel.name()},
+    features_{std::move(feats)}
+{
+    for (auto feat: features_) {
+        if (!detail::feature_is_integral(feat)) {
+            throw std::invalid_argument{"cannot export non-integral feature " + to_string(feat)};
+        }
+    }
+    for (auto&& n: rel) {
+        rows_.push_back(&n);
+    }
+}
+
+std::size_t tensor_export::column(feature_name feat, std::ptrdiff_t offset) const {
+    const auto f = std::find(features_.begin(), features_.end(), feat);
+    if (f == features_.end()) {
+        throw std::out_of_range{"feature " + to_string(feat) + " is not exported"};
+    }
+    if (offset < -static_cast<std::ptrdiff_t>(before_) || offset > static_cast<std::ptrdiff_t>(after_)) {
+        throw std::out_of_range{"offset " + std::to_string(offset) + " is outside of context window"};
+    }
+    const auto slot = static_cast<std::size_t>(offset + static_cast<std::ptrdiff_t>(before_));
+    return slot * features_.size() + static_cast<std::size_t>(f - features_.begin());
+}
+
+template<typename T>
+void tensor_export::fill_(T* out, std::size_t size, T missing) const {
+    if (size < this->size()) {
+        throw std::invalid_argument{"buffer of " + std::to_string(size) + " values too small for "
+                + std::to_string(this->size())};
+    }
+    const auto nrows = rows();
+    const auto nfeats = features_.size();
+    // the features are read once per node, then copied to all the rows having it in context
+    std::vector<T> values(nrows * nfeats, missing);
+    for (std::size_t r = 0; r < nrows; ++r) {
+        const auto& feats = rows_[r]->features();
+        for (std::size_t f = 0; f < nfeats; ++f) {
+            if (auto v = feats.get(features_[f])) {
+                values[r * nfeats + f] = static_cast<T>(detail::feature_value_to_uint(features_[f], *v));
+            }
+        }
+    }
+    const auto ncols = columns();
+    const auto window = before_ + 1 + after_;
+    for (std::size_t r = 0; r < nrows; ++r) {
+        for (std::size_t slot = 0; slot < window; ++slot) {
+            // row of the context node, wrapping around below zero is caught by the bound check
+            const auto src = r + slot - before_;
+            const bool inside = r + slot >= before_ && src < nrows;
+            for (std::size_t f = 0; f < nfeats; ++f) {
+                const auto c = slot * nfeats + f;
+                const auto val = inside ? values[src * nfeats + f] : missing;
+                if (layout_ == tensor_layout::row_major) {
+                    out[r * ncols + c] = val;
+                } else {
+                    out[c * nrows + r] = val;
+                }
+            }
+        }
+    }
+}
+
+void tensor_export::fill(float* out, std::size_t size, float missing) const {
+    fill_(out, size, missing);
+}
+
+void tensor_export::fill(double* out, std::size_t size, double missing) const {
+    fill_(out, size, missing);
+}
+
+void tensor_export::fill_ancestors(relation_name ancestor, std::int64_t* out, std::size_t size) const {
+    const auto depth = hierarchy_distance(relation_, ancestor);
+    if (depth <= 0) {
+        throw std::invalid_argument{"relation " + to_string(ancestor) + " is not above " + to_string(relation_)};
+    }
+    if (size < rows()) {
+        throw std::invalid_argument{"buffer of " + std::to_string(size) + " values too small for "
+                + std::to_string(rows())};
+    }
+    std::unordered_map<const node*, std::int64_t> index;
+    if (!rows_.empty()) {
+        if (auto rel = rows_.front()->graph().get(ancestor)) {
+            std::int64_t i = 0;
+            for (auto&& n: *rel) {
+                index.emplace(&n, i++);
+            }
+        }
+    }
+    for (std::size_t r = 0; r < rows(); ++r) {
+        auto x = rows_[r]->parent().get();
+        for (int hop = 1; x != nullptr && hop < depth; ++hop) {
+            x = x->parent().get();
+        }
+        const auto it = x != nullptr ? index.find(x) : index.end();
+        out[r] = it != index.end() ? it->second : -1;
+    }
+}
+}  // namespace hrglib
@@ -0,0 +1,189 @@
+#include "hrglib/transaction.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/features.hpp"
+
+#include "graph_access.hpp"
+
+#include <utility>
+
+namespace hrglib {
+graph::transaction::transaction(graph& g):
+    graph_{g}
+{
+    detail::graph_access::add_listener(g, *this);
+}
+
+graph::transaction::~transaction() {
+    rollback();
+}
+
+void graph::transaction::finish_() noexcept {
+    if (active_) {
+        detail::graph_access::remove_listener(graph_, *this);
+        active_ = false;
+    }
+}
+
+void graph::transaction::commit() noexcept {
+    finish_();
+    log_.clear();
+    values_.clear();
+    erasures_.clear();
+    dead_.clear();
+}
+
+void graph::transaction::rollback() {
+    if (!active_) {
+        return;
+    }
+    // the edits done here must not end up in our own log
+    finish_();
+    using detail::graph_access;
+    auto& remap = restored_;
+    const auto resolve = [&remap](node* n) {
+        if (n != nullptr) {
+            if (auto it = remap.find(n); it != remap.end()) {
+                return it->second;
+            }
+        }
+        return n;
+    };
+    for (auto e = log_.rbegin(); e != log_.rend(); ++e) {
+        switch (e->what) {
+        case kind::link:
+            graph_access::assign_link(*resolve(e->handle), e->link, resolve(e->target));
+            break;
+        case kind::ends:
+            graph_access::set_ends(*e->rel, resolve(e->target), resolve(e->other));
+            break;
+        case kind::feature:
+            if (auto& val = values_[e->extra]) {
+                graph_access::put_feature(resolve(e->handle)->features(), e->feature, std::move(*val));
+            } else {
+                resolve(e->handle)->features().erase(e->feature);
+            }
+            break;
+        case kind::created: {
+            auto n = resolve(e->handle);
+            n->relation().erase(*n);
+            remap.erase(e->handle);
+            break;
+        }
+        case kind::erased: {
+            auto& er = erasures_[e->extra];
+            auto& n = e->rel->create(resolve(er.sibling));
+            for (auto&& kv: er.features) {
+                graph_access::put_feature(n.features(), kv.first, std::move(kv.second));
+            }
+            for (std::size_t p = 0; p < er.links.size(); ++p) {
+                graph_access::assign_link(n, static_cast<pivot>(p), resolve(er.links[p]));
+            }
+            for (auto&& bl: er.back_links) {
+                graph_access::assign_link(*resolve(bl.first), bl.second, &n);
+            }
+            if (er.first || er.last) {
+                graph_access::set_ends(*e->rel,
+                        er.first ? &n : e->rel->first().get(),
+                        er.last ? &n : e->rel->last().get());
+            }
+            remap[e->handle] = &n;
+            break;
+        }
+        }
+    }
+    log_.clear();
+    values_.clear();
+    erasures_.clear();
+    dead_.clear();
+}
+
+node* graph::transaction::restored(const node* old) const noexcept {
+    if (auto it = restored_.find(old); it != restored_.end()) {
+        return it->second;
+    }
+    return const_cast<node*>(old);
+}
+
+void graph::transaction::node_created(node& n) {
+    if (!dead_.empty()) {
+        dead_.erase(&n);
+    }
+    log_.push_back({kind::created, &n});
+}
+
+void graph::transaction::node_erasing(node& n) {
+    auto& r = n.relation();
+    erasure er;
+    for (std::size_t p = 0; p < er.links.size(); ++p) {
+        er.links[p] = n.link(static_cast<pivot>(p)).get();
+    }
+    // the links the erasure clears afterwards aren't logged, they are restored from here
+    if (auto prev = n.prev().get(); prev != nullptr && prev->next().get() == &n) {
+        er.back_links.emplace_back(prev, pivot::next);
+    }
+    if (auto next = n.next().get(); next != nullptr && next->prev().get() == &n) {
+        er.back_links.emplace_back(next, pivot::prev);
+    }
+    if (auto parent = n.parent().get(); parent != nullptr) {
+        if (parent->first_child().get() == &n) {
+            er.back_links.emplace_back(parent, pivot::first_child);
+        }
+        if (parent->last_child().get() == &n) {
+            er.back_links.emplace_back(parent, pivot::last_child);
+        }
+    }
+    for (auto child = n.first_child().get(); child != nullptr; child = child->next().get()) {
+        if (child->parent().get() == &n) {
+            er.back_links.emplace_back(child, pivot::parent);
+        }
+        if (child == n.last_child().get()) {
+            break;
+        }
+    }
+    er.sibling = nullptr;
+    for (auto&& kv: n.relations()) {
+        if (&kv.second.get() != &n) {
+            er.sibling = &kv.second.get();
+            break;
+        }
+    }
+    if (er.sibling == nullptr) {
+        er.features.assign(n.features().begin(), n.features().end());
+    }
+    er.first = r.first().get() == &n;
+    er.last = r.last().get() == &n;
+    log_.push_back({kind::erased, &n, nullptr, nullptr, &r, pivot::COUNT, feature_name::COUNT,
+            erasures_.size()});
+    erasures_.push_back(std::move(er));
+    dead_.insert(&n);
+}
+
+void graph::transaction::link_changing(node& n, pivot p) {
+    const auto old = n.link(p).get();
+    if (!dead_.empty() && dead_.count(old) != 0) {
+        return;
+    }
+    log_.push_back({kind::link, &n, old, nullptr, nullptr, p});
+}
+
+void graph::transaction::relation_changing(relation& r) {
+    const auto first = r.first().get();
+    const auto last = r.last().get();
+    if (!dead_.empty() && (dead_.count(first) != 0 || dead_.count(last) != 0)) {
+        return;
+    }
+    log_.push_back({kind::ends, nullptr, first, last, &r});
+}
+
+void graph::transaction::feature_changing(node& n, feature_name feat) {
+    optional<any> old;
+    if (auto val = n.features().get(feat)) {
+        old = *val;
+    }
+    log_.push_back({kind::feature, &n, nullptr, nullptr, nullptr, pivot::COUNT, feat,
+            values_.size()});
+    values_.push_back(std::move(old));
+}
+}  // namespace hrglib
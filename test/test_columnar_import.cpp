@@ -0,0 +1,81 @@
+#include "hrglib/columnar_import.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/error.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace hrglib::test {
+TEST(columnar_import, append_bulk) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    auto& w0 = words.append();
+    auto added = words.append_bulk(3);
+    EXPECT_EQ(std::distance(added.begin(), added.end()), 3);
+    EXPECT_EQ(&*added.begin(), w0.next());
+    EXPECT_EQ(std::distance(words.begin(), words.end()), 4);
+    EXPECT_EQ(words.size(), 4);
+    auto& tail = *words.last();
+    EXPECT_EQ(words.append().prev(), &tail);
+}
+
+TEST(columnar_import, hierarchy) {
+    graph g;
+    const std::vector<std::uint64_t> starts{0, 4};
+    const std::vector<string> names{"foo", "bar"};
+    const std::vector<string> word_names{"f", "oo", "bar"};
+    const std::vector<std::int64_t> word_parents{0, 0, 1};
+    const std::vector<std::int64_t> syllable_parents{0, 1, 1, -1};
+    import_columns(g, {
+        {R::Token, 2, R::INVALID, nullptr, {{F::start_pos, starts.data()}}, {{F::name, names.data()}}},
+        {R::Word, 3, R::Token, word_parents.data(), {}, {{F::name, word_names.data()}}},
+        {R::Syllable, 4, R::Word, syllable_parents.data(), {}, {}},
+    });
+
+    auto& tokens = g.at<R::Token>();
+    auto& bar = *tokens.last();
+    EXPECT_EQ(*bar.features().get<F::start_pos>(), 4);
+    EXPECT_EQ(*bar.features().get<F::name>(), "bar");
+    EXPECT_EQ(*tokens.first()->last_child()->features().get<F::name>(), "oo");
+    EXPECT_EQ(bar.first_child(), bar.last_child());
+    EXPECT_EQ(bar.first_child()->parent(), &bar);
+    auto& oo = *tokens.first()->last_child();
+    EXPECT_EQ(oo.first_child(), g.at<R::Syllable>().first()->next());
+    EXPECT_EQ(oo.last_child()->parent(), &oo);
+    EXPECT_FALSE(g.at<R::Syllable>().last()->parent());
+}
+
+TEST(columnar_import, errors) {
+    graph g;
+    const std::vector<std::int64_t> parents{0, 1, 0};
+    const std::vector<std::int64_t> out_of_range{5};
+    EXPECT_THROW(import_columns(g, {{R::Word, 3, R::Token, parents.data(), {}, {}}}), std::invalid_argument);
+    EXPECT_THROW(import_columns(g, {
+        {R::Token, 2, R::INVALID, nullptr, {}, {}},
+        {R::Word, 3, R::Token, parents.data(), {}, {}},
+    }), std::invalid_argument);
+    EXPECT_THROW(import_columns(g, {
+        {R::Token, 2, R::INVALID, nullptr, {}, {}},
+        {R::Word, 1, R::Token, out_of_range.data(), {}, {}},
+    }), std::out_of_range);
+    EXPECT_THROW(import_columns(g, {
+        {R::Word, 2, R::INVALID, nullptr, {}, {}},
+        {R::Token, 1, R::Word, parents.data(), {}, {}},
+    }), error::bad_relation);
+    const std::vector<string> bad_pos{"x"};
+    EXPECT_THROW(import_columns(g, {
+        {R::Token, 1, R::INVALID, nullptr, {}, {{F::start_pos, bad_pos.data()}}},
+    }), error::invalid_feature_type);
+    // failed imports add no nodes
+    EXPECT_EQ(g.at<R::Token>().size(), 0);
+    EXPECT_EQ(g.at<R::Word>().size(), 0);
+    EXPECT_FALSE(g.at<R::Token>().first());
+}
+}  // namespace hrglib::test
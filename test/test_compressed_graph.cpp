@@ -0,0 +1,74 @@
+#include "hrglib/compressed_graph.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/word.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+std::size_t yaml_size(const graph& g) {
+    std::ostringstream os;
+    os << g;
+    return os.str().size();
+}
+}  // namespace
+
+TEST(compressed_graph, round_trip) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    const auto c = g.compress();
+    auto d = c.decompress();
+    EXPECT_EQ(names(d.at<R::Token>()), names(g.at<R::Token>()));
+    EXPECT_EQ(names(d.at<R::Word>()), names(g.at<R::Word>()));
+    EXPECT_EQ(d.at<R::Word>().first()->parent(), d.at<R::Token>().first());
+    EXPECT_EQ(d.at<R::Token>().first()->last_child(), d.at<R::Word>().last());
+    EXPECT_EQ(d.at<R::Token>().last(), d.at<R::Token>().first()->next());
+    EXPECT_EQ(dump(d), dump(g));
+
+    const auto copy = compressed_graph::from_bytes(string{c.bytes()});
+    EXPECT_EQ(names(copy.decompress().at<R::Word>()), names(g.at<R::Word>()));
+}
+
+TEST(compressed_graph, shared_contents_and_large_graph) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    for (std::size_t i = 0; i < 2000; ++i) {
+        auto& t = tokens.append();
+        t.features().set<F::name>(i % 2 ? "the" : "cat");
+        t.features().set<F::start_pos>(4 * i);
+        t.features().set<F::end_pos>(4 * i + 3);
+        auto& w = words.append(&t);
+        w.set_parent(&t);
+        t.set_first_child(&w).set_last_child(&w);
+    }
+    const auto c = g.compress();
+    // interned strings, varint links and positions vs YAML with hashed ids
+    EXPECT_LT(c.size() * 5, yaml_size(g));
+
+    auto d = c.decompress();
+    ASSERT_EQ(d.at<R::Word>().size(), 2000);
+    EXPECT_EQ(names(d.at<R::Word>()), names(g.at<R::Word>()));
+    auto& w = *d.at<R::Word>().last();
+    EXPECT_EQ(&w.features(), &w.as<R::Token>()->features());
+    EXPECT_EQ(w.features().at<F::end_pos>(), 4 * 1999 + 3);
+}
+
+TEST(compressed_graph, malformed_throws) {
+    EXPECT_THROW(compressed_graph::from_bytes("").decompress(), error::parsing_error);
+    auto c = graph::from_file(data_file("test_graph.yaml")).compress();
+    auto bytes = string{c.bytes()};
+    bytes.pop_back();
+    EXPECT_THROW(compressed_graph::from_bytes(bytes).decompress(), error::parsing_error);
+}
+}  // namespace hrglib::test
@@ -0,0 +1,130 @@
+#include "hrglib/derived_features.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+
+namespace hrglib::test {
+namespace {
+struct fixture {
+    graph g = graph::from_file(data_file("test_graph.yaml"));
+    derived_features df{g};
+    //! Position of node in its relation.
+    derived_feature<std::size_t> position = df.define<std::size_t>([](const node& n, derived_features::reader& r) {
+        std::size_t i = 0;
+        for (auto p = r.prev(&n); p; p = r.prev(p)) {
+            ++i;
+        }
+        return i;
+    });
+    derived_feature<std::size_t> name_length = df.define<std::size_t>([](const node& n, derived_features::reader& r) {
+        auto name = r.get<F::name>(&n);
+        return name ? name->size() : 0;
+    });
+    //! Length of name of the parent, through other derived feature.
+    derived_feature<std::size_t> parent_name_length = df.define<std::size_t>(
+            [this](const node& n, derived_features::reader& r) -> std::size_t {
+        auto p = r.parent(&n);
+        return p ? r.get(name_length, *p) : 0;
+    });
+
+    node& baz() { return *g.at(R::Word).first(); }
+    node& zaz() { return *g.at(R::Word).last(); }
+    node& foo() { return *g.at(R::Token).first(); }
+};
+}  // namespace
+
+TEST(derived_features, memoized) {
+    fixture f;
+    EXPECT_EQ(f.df.get(f.position, f.zaz()), 1);
+    EXPECT_EQ(f.df.get(f.position, f.zaz()), 1);
+    EXPECT_EQ(f.df.get(f.position, f.baz()), 0);
+    EXPECT_EQ(f.df.stats(f.position).hits, 1);
+    EXPECT_EQ(f.df.stats(f.position).misses, 2);
+    EXPECT_DOUBLE_EQ(f.df.stats(f.position).hit_rate(), 1. / 3);
+    EXPECT_EQ(f.df.size(), 2);
+    EXPECT_EQ(f.df.stats().misses, 2);
+}
+
+TEST(derived_features, invalidated_by_feature) {
+    fixture f;
+    EXPECT_EQ(f.df.get(f.name_length, f.zaz()), 3);
+    f.baz().features().set<F::name>("bazzz");
+    EXPECT_EQ(f.df.get(f.name_length, f.zaz()), 3);
+    EXPECT_EQ(f.df.stats(f.name_length).hits, 1);
+    f.zaz().features().set<F::name>("zazzz");
+    EXPECT_EQ(f.df.stats(f.name_length).invalidations, 1);
+    EXPECT_EQ(f.df.get(f.name_length, f.zaz()), 5);
+    f.zaz().features().erase(F::name);
+    EXPECT_EQ(f.df.get(f.name_length, f.zaz()), 0);
+}
+
+TEST(derived_features, invalidated_by_link) {
+    fixture f;
+    EXPECT_EQ(f.df.get(f.position, f.zaz()), 1);
+    EXPECT_EQ(f.df.get(f.position, f.foo()), 0);
+    f.baz().insert_prev();
+    EXPECT_EQ(f.df.stats(f.position).invalidations, 1);
+    EXPECT_EQ(f.df.get(f.position, f.zaz()), 2);
+    // token position didn't depend on the words
+    EXPECT_EQ(f.df.get(f.position, f.foo()), 0);
+    EXPECT_EQ(f.df.stats(f.position).hits, 1);
+}
+
+TEST(derived_features, cascades) {
+    fixture f;
+    EXPECT_EQ(f.df.get(f.parent_name_length, f.zaz()), 3);
+    EXPECT_EQ(f.df.get(f.parent_name_length, f.baz()), 3);
+    f.foo().features().set<F::name>("foobar");
+    EXPECT_EQ(f.df.stats(f.parent_name_length).invalidations, 2);
+    EXPECT_EQ(f.df.get(f.parent_name_length, f.zaz()), 6);
+
+    f.g.at(R::Word).erase(f.baz());
+    EXPECT_EQ(f.df.get(f.parent_name_length, f.zaz()), 6);
+    EXPECT_EQ(f.df.get(f.position, f.zaz()), 0);
+    f.df.clear();
+    EXPECT_EQ(f.df.size(), 0);
+    EXPECT_EQ(f.df.dependencies(), 0);
+}
+
+TEST(derived_features, dependencies_bounded) {
+    fixture f;
+    // reads the same feature twice
+    auto twice = f.df.define<std::size_t>([](const node& n, derived_features::reader& r) -> std::size_t {
+        return r.get<F::name>(&n)->size() + r.get<F::name>(&n)->size();
+    });
+    EXPECT_EQ(f.df.get(twice, f.zaz()), 6);
+    EXPECT_EQ(f.df.get(f.parent_name_length, f.zaz()), 3);
+    const auto deps = f.df.dependencies();
+    for (int i = 0; i < 10; ++i) {
+        f.zaz().features().set<F::name>("zaz");
+        f.foo().features().set<F::name>("foo");
+        EXPECT_EQ(f.df.get(twice, f.zaz()), 6);
+        EXPECT_EQ(f.df.get(f.parent_name_length, f.zaz()), 3);
+    }
+    EXPECT_EQ(f.df.dependencies(), deps);
+    EXPECT_EQ(f.df.stats(twice).invalidations, 10);
+}
+
+TEST(derived_features, self_dependency) {
+    fixture f;
+    std::optional<derived_feature<int>> self;
+    self = f.df.define<int>([&self](const node& n, derived_features::reader& r) {
+        return r.get(*self, n) + 1;
+    });
+    EXPECT_THROW(f.df.get(*self, f.zaz()), std::logic_error);
+    EXPECT_EQ(f.df.size(), 0);
+    EXPECT_EQ(f.df.dependencies(), 0);
+    // not stuck in the computing state
+    EXPECT_THROW(f.df.get(*self, f.zaz()), std::logic_error);
+}
+}  // namespace hrglib::test
@@ -5,14 +5,29 @@
 #include "hrglib/word.hpp"
 #include "hrglib/relation.hpp"
 #include "hrglib/relation_name.hpp"
+#include "hrglib/projection.hpp"
+#include "hrglib/order_index.hpp"
 #include "hrglib/string.hpp"
 
 #include "utils.hpp"
 
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
 #include <stdexcept>
 namespace hrglib::test {
+namespace {
+//! Names of the nodes in the sequence of @p r, separated by spaces.
+string text(const relation& r) {
+    string res;
+    for (auto&& n: r) {
+        res += (res.empty() ? "" : " ") + *n.features().get<F::name>();
+    }
+    return res;
+}
+}  // namespace
 
 TEST(graph, from_file_success) {
     auto g = graph::from_file(data_file("test_graph.yaml"));
@@ -65,6 +80,438 @@ TEST(graph, from_string_throws) {
     EXPECT_THROW(graph::from_string("[ \"foo\" ]"), std::runtime_error);
 }
 
+TEST(graph, from_file_projection) {
+    auto g = graph::from_file(data_file("test_graph.yaml"), projection{{R::Token}, {}});
+    EXPECT_TRUE(g.has(R::Token));
+    EXPECT_FALSE(g.has(R::Word));
+    ASSERT_EQ(g.at<R::Token>().size(), 2);
+    auto t = g.at<R::Token>().first();
+    ASSERT_TRUE(t);
+    EXPECT_EQ(t->next(), g.at<R::Token>().last());
+    // links into dropped Word relation are cut
+    EXPECT_FALSE(t->first_child());
+    EXPECT_FALSE(t->last_child());
+    EXPECT_TRUE(t->features().empty());
+}
+
+TEST(graph, from_string_projection_features) {
+    auto yaml = R"EOF({
+        nodes: [
+            { features: { name: foo, start_pos: 1, end_pos: 4 },
+              relations: { Token: { id: 0, first_child: 1 }, Word: { id: 1, parent: 0 } } },
+            { features: { name: bar },
+              relations: { Syllable: { id: 2, parent: 1 } } }
+        ],
+        relations: { Token: { first: 0 }, Word: { first: 1 }, Syllable: { first: 2 } }
+    })EOF";
+    auto g = graph::from_string(yaml, projection{}.keep(F::name).keep(F::start_pos)
+            .keep(R::Token).keep(R::Word));
+    EXPECT_FALSE(g.has(R::Syllable));
+    ASSERT_TRUE(g.has(R::Word));
+    auto w = g.at<R::Word>().first();
+    ASSERT_TRUE(w);
+    EXPECT_EQ(w->as<R::Token>(), g.at<R::Token>().first());
+    EXPECT_FALSE(w->first_child());
+    EXPECT_EQ(w->features().size(), 2);
+    EXPECT_EQ(*w->features().get<F::start_pos>(), 1);
+    EXPECT_FALSE(w->features().has(F::end_pos));
+    // projection keeping everything is the same as plain loading
+    auto full = graph::from_string(yaml, projection{});
+    EXPECT_EQ(full.at<R::Syllable>().size(), 1);
+}
+
+TEST(graph, append_long_relations) {
+    constexpr std::size_t count = 100000;
+    graph g;
+    // closed relation
+    auto& tokens = g.at<R::Token>();
+    for (std::size_t i = 0; i < count; ++i) {
+        tokens.append();
+    }
+    EXPECT_EQ(std::distance(tokens.begin(), tokens.end()), count);
+
+    // open relation: first set, last never is
+    auto& words = g.at<R::Word>();
+    auto& first = words.create();
+    words.set_first(&first);
+    word* last = &first;
+    for (std::size_t i = 1; i < count; ++i) {
+        last = &words.append();
+    }
+    EXPECT_FALSE(words.last());
+    EXPECT_EQ(last->prev()->next(), last);
+    // the tail is found again after other changes of the sequence
+    auto& before_last = *last->prev();
+    words.erase(*last);
+    EXPECT_EQ(words.append().prev(), &before_last);
+    std::size_t n = 0;
+    for (auto w = first.nav(); w; w = w->next()) {
+        ++n;
+    }
+    EXPECT_EQ(n, count);
+}
+
+TEST(graph, batch_erase) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    const char* names[] = {"a", ",", "b", ".", "!", "c", "?"};
+    for (auto name: names) {
+        auto& t = tokens.append();
+        t.features().set<F::name>(name);
+        auto& w = words.append(&t);
+        t.set_first_child(&w).set_last_child(&w);
+    }
+    const auto is_punc = [](const token& t) { return string{",.!?"}.find(*t.features().get<F::name>()) != string::npos; };
+    EXPECT_EQ(tokens.erase_if(is_punc, true), 4);
+    EXPECT_EQ(text(tokens), "a b c");
+    EXPECT_EQ(text(words), "a b c");
+    EXPECT_EQ(words.size(), 3);
+    EXPECT_EQ(*tokens.last()->features().get<F::name>(), "c");
+    EXPECT_EQ(tokens.last()->prev()->next(), tokens.last());
+
+    // range up to end, then from begin
+    EXPECT_EQ(words.erase(std::next(words.begin()), words.end()), 2);
+    EXPECT_EQ(text(words), "a");
+    EXPECT_EQ(words.last(), words.first());
+    EXPECT_EQ(tokens.erase(tokens.begin(), std::next(tokens.begin())), 1);
+    EXPECT_EQ(text(tokens), "b c");
+    EXPECT_FALSE(tokens.first()->prev());
+    // handles of erased tokens in Word went with them only on request
+    EXPECT_EQ(words.size(), 1);
+    EXPECT_FALSE(words.first()->in(R::Token));
+}
+
+TEST(graph, batch_erase_sizes) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    int i = 0;
+    for (auto&& w: words.append_bulk(100)) {
+        w.features().set<F::name>(std::to_string(i++));
+    }
+    const auto parity = [](const word& w) { return std::stoi(*w.features().get<F::name>()) % 2; };
+    // a few nodes are looked up one by one, most of the relation is swept
+    EXPECT_EQ(words.erase_if([&](const word& w) { return *w.features().get<F::name>() == "1"; }), 1);
+    EXPECT_EQ(words.erase_if([&](const word& w) { return parity(w) == 1; }), 49);
+    EXPECT_EQ(words.size(), 50);
+    EXPECT_EQ(name_of(words.first()), "0");
+    EXPECT_EQ(name_of(words.last()), "98");
+    EXPECT_EQ(name_of(words.first()->next()), "2");
+    std::size_t n = 0;
+    for (auto&& w: words) {
+        EXPECT_EQ(parity(w), 0);
+        ++n;
+    }
+    EXPECT_EQ(n, 50);
+    // ids of all erased nodes are reused
+    words.append_bulk(50);
+    EXPECT_EQ(words.id_bound(), 100);
+}
+
+TEST(graph, batch_erase_children) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    auto& t = tokens.append();
+    const auto fill = [&](std::initializer_list<const char*> names) {
+        for (auto name: names) {
+            auto& w = words.append();
+            w.features().set<F::name>(name);
+            w.set_parent(&t);
+            if (!t.first_child()) {
+                t.set_first_child(&w);
+            }
+            t.set_last_child(&w);
+        }
+    };
+    const auto named = [](const char* name) {
+        return [name](const word& w) { return *w.features().get<F::name>() == name; };
+    };
+
+    fill({"w1", "w2", "w3"});
+    words.erase_if(named("w1"));
+    EXPECT_EQ(name_of(t.first_child()), "w2");
+    EXPECT_EQ(name_of(t.last_child()), "w3");
+    words.erase_if(named("w3"));
+    EXPECT_EQ(name_of(t.first_child()), "w2");
+    EXPECT_EQ(name_of(t.last_child()), "w2");
+    words.erase_if(named("w2"));
+    EXPECT_FALSE(t.first_child());
+    EXPECT_FALSE(t.last_child());
+
+    fill({"a", "b", "c", "d"});
+    words.erase(std::next(words.begin()), std::next(words.begin(), 3));
+    EXPECT_EQ(name_of(t.first_child()), "a");
+    EXPECT_EQ(name_of(t.last_child()), "d");
+    EXPECT_EQ(t.first_child()->next(), t.last_child());
+    words.erase(std::next(words.begin()), words.end());
+    EXPECT_EQ(name_of(t.first_child()), "a");
+    EXPECT_EQ(name_of(t.last_child()), "a");
+    words.erase(words.begin(), words.end());
+    EXPECT_FALSE(t.first_child());
+    EXPECT_FALSE(t.last_child());
+}
+
+TEST(graph, splice) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    auto& syllables = g.at<R::Syllable>();
+    // tokens with two words each, every word with single syllable of the same name
+    for (auto name: {"a", "b", "c"}) {
+        auto& t = tokens.append();
+        t.features().set<F::name>(name);
+        for (auto i: {"1", "2"}) {
+            auto& w = words.append();
+            w.features().set<F::name>(name + string{i});
+            if (!t.first_child()) {
+                t.set_first_child(&w);
+            }
+            t.set_last_child(&w);
+            auto& s = syllables.append();
+            s.features().set<F::name>(name + string{i});
+            w.set_first_child(&s).set_last_child(&s);
+        }
+    }
+    const auto children = [](const node& p) {
+        string res;
+        for (auto c = p.first_child(); c; c = c->next()) {
+            res += *c->features().get<F::name>();
+            if (c == p.last_child()) {
+                break;
+            }
+        }
+        return res;
+    };
+    auto& a = *tokens.first();
+    auto& b = *a.next();
+    auto& c = *b.next();
+    auto named = [&](string_view name) -> word& {
+        for (auto&& w: words) {
+            if (*w.features().get<F::name>() == name) {
+                return w;
+            }
+        }
+        throw std::out_of_range{"no such word"};
+    };
+
+    // subtrees move along
+    tokens.splice(nullptr, a, a, true);
+    EXPECT_EQ(text(tokens), "b c a");
+    EXPECT_EQ(text(words), "b1 b2 c1 c2 a1 a2");
+    EXPECT_EQ(text(syllables), "b1 b2 c1 c2 a1 a2");
+    EXPECT_EQ(tokens.first(), &b);
+    EXPECT_EQ(tokens.last(), &a);
+    EXPECT_EQ(children(a), "a1a2");
+    EXPECT_EQ(children(named("a2")), "a2");
+
+    // reordering within parent
+    words.splice(&named("c1"), named("c2"), named("c2"));
+    EXPECT_EQ(text(words), "b1 b2 c2 c1 a1 a2");
+    EXPECT_EQ(text(syllables), "b1 b2 c1 c2 a1 a2");
+    EXPECT_EQ(children(c), "c2c1");
+    words.splice(&named("a1"), named("c2"), named("c2"));
+    EXPECT_EQ(children(c), "c1c2");
+
+    // moving among children of other parent
+    words.splice(&named("a2"), named("b1"), named("b1"));
+    EXPECT_EQ(text(words), "b2 c1 c2 a1 b1 a2");
+    EXPECT_EQ(children(b), "b2");
+    EXPECT_EQ(children(a), "a1b1a2");
+    EXPECT_EQ(words.first(), &named("b2"));
+
+    // whole children of a parent stay with it, others get detached
+    words.splice(&named("a1"), named("b2"), named("b2"));
+    EXPECT_EQ(text(words), "c1 c2 b2 a1 b1 a2");
+    EXPECT_EQ(children(b), "b2");
+    words.splice(&named("c1"), named("a1"), named("b1"));
+    EXPECT_EQ(text(words), "a1 b1 c1 c2 b2 a2");
+    EXPECT_EQ(children(a), "a2");
+    EXPECT_FALSE(named("a1").parent());
+    EXPECT_FALSE(named("b1").parent());
+    EXPECT_EQ(words.last(), &named("a2"));
+
+    EXPECT_THROW(words.splice(&named("c2"), named("a2"), named("a2")), std::invalid_argument);
+    EXPECT_EQ(text(words), "a1 b1 c1 c2 b2 a2");
+    EXPECT_THROW(static_cast<relation&>(words).splice(nullptr, a, a), error::bad_relation);
+}
+
+TEST(graph, splice_children_next_to_neighbours) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    auto add = [&](const char* name) -> auto& {
+        auto& t = tokens.append();
+        t.features().set<F::name>(name);
+        return t;
+    };
+    auto& x = add("x");
+    auto& a = add("a");
+    auto& y = add("y");
+    auto& b = add("b");
+    auto& z = add("z");
+    for (auto t: {&a, &b}) {
+        auto& w = words.append();
+        w.features().set<F::name>(*t->features().get<F::name>() + string{"1"});
+        t->set_first_child(&w).set_last_child(&w);
+    }
+
+    // to the front, before the first of all children
+    tokens.splice(&x, b, b, true);
+    EXPECT_EQ(text(tokens), "b x a y z");
+    EXPECT_EQ(text(words), "b1 a1");
+    // after the children of the preceding node
+    tokens.splice(&y, b, b, true);
+    EXPECT_EQ(text(tokens), "x a b y z");
+    EXPECT_EQ(text(words), "a1 b1");
+    // before the children of the following node
+    tokens.splice(&a, b, b, true);
+    EXPECT_EQ(text(tokens), "x b a y z");
+    EXPECT_EQ(text(words), "b1 a1");
+    // to the end
+    tokens.splice(nullptr, b, b, true);
+    EXPECT_EQ(text(tokens), "x a y z b");
+    EXPECT_EQ(text(words), "a1 b1");
+    // between nodes having no children to place them next to
+    EXPECT_THROW(tokens.splice(&z, b, b, true), std::invalid_argument);
+    EXPECT_EQ(text(tokens), "x a y z b");
+    EXPECT_EQ(text(words), "a1 b1");
+    EXPECT_EQ(b.first_child(), words.last());
+}
+
+TEST(graph, move) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    graph moved{std::move(g)};
+    EXPECT_FALSE(g.get(R::Word));
+    auto& words = moved.at<R::Word>();
+    EXPECT_EQ(&words.graph(), &moved);
+    EXPECT_EQ(&words.first()->graph(), &moved);
+    EXPECT_EQ(text(words), "baz zaz");
+    words.append().set_parent(&*moved.at<R::Token>().first());
+
+    // listeners other than the journal would be left behind
+    order_index idx{words};
+    EXPECT_THROW(graph{std::move(moved)}, std::invalid_argument);
+    EXPECT_EQ(&words.graph(), &moved);
+}
+
+TEST(graph, append_graph) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto other = graph::from_file(data_file("test_graph.yaml"));
+    auto& bar = *other.at<R::Token>().last();
+    other.at<R::Word>().last()->features().set<F::name>("zaz2");
+    other.at<R::Syllable>().append().features().set<F::name>("syl");
+
+    other.start_journal();
+    EXPECT_THROW(g.append_graph(std::move(other)), std::invalid_argument);
+    other.stop_journal();
+    EXPECT_THROW(g.append_graph(std::move(g)), std::invalid_argument);
+
+    g.append_graph(std::move(other));
+    EXPECT_FALSE(other.has(R::Token));
+    EXPECT_EQ(text(g.at(R::Token)), "foo bar foo bar");
+    EXPECT_EQ(text(g.at(R::Word)), "baz zaz baz zaz2");
+    EXPECT_EQ(text(g.at(R::Syllable)), "syl");
+    EXPECT_EQ(g.at<R::Token>().size(), 4);
+    EXPECT_EQ(g.at<R::Token>().last(), &bar);
+    EXPECT_EQ(&bar.relation(), &g.at(R::Token));
+    EXPECT_EQ(&bar.graph(), &g);
+    EXPECT_GE(bar.id(), 2);
+    EXPECT_LT(bar.id(), 4);
+    EXPECT_EQ(g.at(R::Token).id_bound(), 4);
+    auto& zaz2 = *g.at<R::Word>().last();
+    EXPECT_EQ(*zaz2.parent()->features().get<F::name>(), "foo");
+    EXPECT_EQ(zaz2.parent()->next(), &bar);
+
+    // the moved nodes work as any other
+    g.at(R::Word).erase(zaz2);
+    EXPECT_EQ(text(g.at(R::Word)), "baz zaz baz");
+    EXPECT_EQ(g.at<R::Token>().append().relation().size(), 5);
+}
+
+TEST(graph, deferred_validation) {
+    auto g = graph::builder{}.with_deferred_validation().build();
+    EXPECT_TRUE(g.validation_deferred());
+    EXPECT_TRUE(g.to_builder().deferred_validation);
+    auto& t = g.at<R::Token>().append();
+    auto& s = g.at<R::Syllable>().append();
+    node& tn = t;
+    // neither of these throws until validation
+    tn.set_parent(&s);
+    tn.set_next(&s);
+    try {
+        g.validate();
+        FAIL() << "expected error::invalid_graph";
+    } catch (const error::invalid_graph& e) {
+        EXPECT_EQ(e.violations.size(), 3);
+    }
+
+    tn.set_parent(nullptr);
+    tn.set_next(nullptr);
+    EXPECT_NO_THROW(g.validate());
+
+    // links into other graph are rejected right away
+    graph other;
+    node& foreign = other.at<R::Token>().append();
+    EXPECT_THROW(tn.set_next(&foreign), std::invalid_argument);
+    EXPECT_THROW(tn.set_prev(&foreign), std::invalid_argument);
+    EXPECT_THROW(tn.set_parent(&foreign), std::invalid_argument);
+    EXPECT_THROW(tn.set_first_child(&foreign), std::invalid_argument);
+    EXPECT_THROW(g.at(R::Token).set_first(&foreign), std::invalid_argument);
+    EXPECT_THROW(g.at(R::Token).set_last(&foreign), std::invalid_argument);
+    EXPECT_FALSE(foreign.prev());
+    EXPECT_FALSE(foreign.next());
+
+    g.defer_validation(false);
+    EXPECT_THROW(tn.set_next(&s), error::bad_relation);
+
+    const auto bad = R"(---
+nodes:
+  - features: {}
+    relations:
+      Word: { id: 0, parent: 1 }
+  - features: {}
+    relations:
+      Word: { id: 1, first_child: 0, last_child: 0 }
+relations:
+  Word: { first: 0, last: 1 }
+)";
+    EXPECT_THROW(graph::from_string(bad), error::bad_relation);
+    try {
+        graph::from_string(bad, graph::builder{}.with_deferred_validation());
+        FAIL() << "expected error::invalid_graph";
+    } catch (const error::invalid_graph& e) {
+        EXPECT_EQ(e.violations.size(), 3);
+    }
+}
+
+TEST(graph, collect) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    auto& t = tokens.append();
+    auto& w = words.create();
+    t.set_first_child(&w).set_last_child(&w);
+    // loose chain and loose handle sharing contents with reachable token
+    auto& l1 = tokens.create();
+    l1.set_next(&tokens.create());
+    words.create(&t);
+    auto& shared = g.at<R::Syllable>().create(&l1);
+    (void) shared;
+    EXPECT_EQ(tokens.size(), 3);
+
+    const auto freed = g.collect();
+    EXPECT_EQ(freed.nodes, 4);
+    // l1 contents shared with its syllable handle, the other loose token, none for the
+    // extra word handle whose contents is kept by the token
+    EXPECT_EQ(freed.contents, 2);
+    EXPECT_EQ(tokens.size(), 1);
+    EXPECT_EQ(words.size(), 1);
+    EXPECT_EQ(g.at(R::Syllable).size(), 0);
+    EXPECT_EQ(w.parent(), &t);
+    EXPECT_EQ(g.collect().nodes, 0);
+}
+
 TEST(graph, format) {
     std::cerr << graph::from_file(data_file("test_graph.yaml")) << std::endl;
 }
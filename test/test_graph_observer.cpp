@@ -0,0 +1,141 @@
+#include "hrglib/graph_observer.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/word.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+struct recorder: graph_observer {
+    std::vector<mutation_event> events;
+    std::size_t batches = 0;
+
+    explicit recorder(hrglib::graph& g, mutation_kinds kinds = mutation_kinds{}.set(), std::size_t batch_size = 0):
+        graph_observer{g, kinds, batch_size}
+    {}
+    ~recorder() override {
+        flush();
+    }
+
+    void on_mutation(const mutation_event& e) override {
+        events.push_back(e);
+    }
+    void on_batch(const std::vector<mutation_event>& batch) override {
+        ++batches;
+        graph_observer::on_batch(batch);
+    }
+
+    std::size_t count(mutation_kind kind) const {
+        std::size_t res = 0;
+        for (auto&& e: events) {
+            res += e.kind == kind;
+        }
+        return res;
+    }
+};
+}  // namespace
+
+TEST(graph_observer, immediate) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto& foo = *g.at<R::Token>().first();
+    recorder r{g};
+    auto& t = g.at<R::Token>().append();
+    ASSERT_EQ(r.events.size(), 4);
+    EXPECT_EQ(r.events[0].kind, mutation_kind::node_created);
+    EXPECT_EQ(r.events[0].target, &t);
+    EXPECT_EQ(r.count(mutation_kind::link_changing), 2);
+    EXPECT_EQ(r.events.back().kind, mutation_kind::relation_changing);
+    EXPECT_EQ(r.events.back().rel, &g.at(R::Token));
+
+    r.events.clear();
+    foo.features().set<F::name>("qux");
+    foo.features().erase(F::name);
+    ASSERT_EQ(r.events.size(), 2);
+    EXPECT_EQ(r.events[1].kind, mutation_kind::feature_changing);
+    EXPECT_EQ(r.events[1].feature, F::name);
+    EXPECT_EQ(r.events[1].target, &foo);
+
+    r.events.clear();
+    g.at(R::Token).erase(t);
+    EXPECT_EQ(r.count(mutation_kind::node_erasing), 1);
+    EXPECT_EQ(r.events[0].target, &t);
+    EXPECT_EQ(r.batches, 0);
+}
+
+TEST(graph_observer, filtered_and_batched) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    mutation_kinds kinds;
+    kinds.set(static_cast<std::size_t>(mutation_kind::link_changing));
+    recorder links{g, kinds, 3};
+    {
+        recorder all{g};
+        g.at<R::Word>().append();
+        EXPECT_EQ(all.events.size(), 4);
+    }
+    EXPECT_EQ(links.events.size(), 0);
+    EXPECT_EQ(links.pending(), 2);
+    g.at<R::Word>().first()->features().set<F::name>("qux");
+    EXPECT_EQ(links.pending(), 2);
+    g.at<R::Word>().append();
+    EXPECT_EQ(links.batches, 1);
+    EXPECT_EQ(links.events.size(), 3);
+    EXPECT_EQ(links.pending(), 1);
+    links.flush();
+    links.flush();
+    EXPECT_EQ(links.batches, 2);
+    EXPECT_EQ(links.events.size(), 4);
+    for (auto&& e: links.events) {
+        EXPECT_EQ(e.kind, mutation_kind::link_changing);
+    }
+    EXPECT_EQ(links.events.back().link, pivot::prev);
+}
+
+TEST(graph_observer, flushed_on_destruction) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    struct counter: recorder {
+        std::size_t& reported;
+        counter(hrglib::graph& g, std::size_t& reported):
+            recorder{g, mutation_kinds{}.set(), 100},
+            reported{reported}
+        {}
+        ~counter() override {
+            flush();
+            reported = events.size();
+        }
+    };
+    std::size_t reported = 0;
+    {
+        counter c{g, reported};
+        g.at<R::Word>().append();
+        EXPECT_EQ(c.pending(), 4);
+    }
+    EXPECT_EQ(reported, 4);
+
+    // without flush() the buffered events are dropped
+    struct forgetful: graph_observer {
+        std::size_t& reported;
+        forgetful(hrglib::graph& g, std::size_t& reported):
+            graph_observer{g, mutation_kinds{}.set(), 100},
+            reported{reported}
+        {}
+        void on_mutation(const mutation_event&) override { ++reported; }
+    };
+    reported = 0;
+    {
+        forgetful f{g, reported};
+        g.at<R::Word>().append();
+        EXPECT_EQ(f.pending(), 4);
+    }
+    EXPECT_EQ(reported, 0);
+    g.at<R::Word>().append();
+    EXPECT_EQ(reported, 0);
+}
+}  // namespace hrglib::test
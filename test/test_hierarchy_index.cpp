@@ -0,0 +1,79 @@
+#include "hrglib/hierarchy_index.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+std::vector<const node*> to_vector(iterator::range<hierarchy_index::leaf_iterator> r) {
+    return {r.begin(), r.end()};
+}
+}  // namespace
+
+TEST(hierarchy_index, queries) {
+    graph g;
+    auto& p = g.at<R::Phrase>().append();
+    auto& t1 = g.at<R::Token>().append();
+    auto& t2 = g.at<R::Token>().append();
+    auto& w1 = g.at<R::Word>().append();
+    auto& w2 = g.at<R::Word>().append();
+    auto& w3 = g.at<R::Word>().append();
+    auto& s1 = g.at<R::Syllable>().append();
+    auto& s2 = g.at<R::Syllable>().append();
+    adopt(p, t1);
+    adopt(p, t2);
+    adopt(t1, w1);
+    adopt(t1, w2);
+    adopt(t2, w3);
+    adopt(w1, s1);
+    adopt(w1, s2);
+    auto& loose = g.at<R::Word>().create();
+
+    hierarchy_index idx{g};
+    EXPECT_EQ(idx.depth(p), 0);
+    EXPECT_EQ(idx.depth(s2), 3);
+    EXPECT_EQ(idx.ancestor(s2, 1), &t1);
+    EXPECT_EQ(idx.ancestor(s2, 3), &s2);
+    EXPECT_FALSE(idx.ancestor(w3, 3));
+    EXPECT_TRUE(idx.is_ancestor(t1, s1));
+    EXPECT_FALSE(idx.is_ancestor(t2, s1));
+    EXPECT_EQ(idx.lca(s1, s2), &w1);
+    EXPECT_EQ(idx.lca(s1, w3), &p);
+    EXPECT_EQ(idx.lca(s1, w1), &w1);
+    EXPECT_FALSE(idx.lca(s1, loose));
+    EXPECT_EQ(to_vector(idx.leaves(p)), (std::vector<const node*>{&s1, &s2, &w2, &w3}));
+    EXPECT_EQ(to_vector(idx.leaves(t2)), (std::vector<const node*>{&w3}));
+    EXPECT_EQ(idx.rebuilds(), 1);
+
+    // rebuilt lazily after change
+    adopt(t2, w2);
+    EXPECT_EQ(idx.lca(w2, w3), &t2);
+    EXPECT_EQ(to_vector(idx.leaves(t1)), (std::vector<const node*>{&s1, &s2}));
+    EXPECT_EQ(idx.rebuilds(), 2);
+}
+
+TEST(hierarchy_index, deep) {
+    // recursive relation like SylStructure
+    auto g = graph::builder{}.with_relation_validator([](const relation&, const relation&) { return true; }).build();
+    auto& words = g.at(R::Word);
+    std::vector<node*> chain;
+    for (int i = 0; i < 100; ++i) {
+        auto& n = words.append();
+        if (!chain.empty()) {
+            n.set_parent(chain.back());
+        }
+        chain.push_back(&n);
+    }
+    hierarchy_index idx{g};
+    EXPECT_EQ(idx.depth(*chain.back()), 99);
+    EXPECT_EQ(idx.ancestor(*chain.back(), 37), chain[37]);
+    EXPECT_EQ(idx.lca(*chain[80], *chain[60]), chain[60]);
+}
+}  // namespace hrglib::test
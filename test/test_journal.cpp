@@ -0,0 +1,160 @@
+#include "hrglib/journal.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/word.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace hrglib::test {
+TEST(journal, disabled_by_default) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    EXPECT_FALSE(g.journal());
+    auto& j = g.start_journal();
+    EXPECT_EQ(&j, &*g.journal());
+    EXPECT_TRUE(j.empty());
+    g.stop_journal();
+    EXPECT_FALSE(g.journal());
+}
+
+TEST(journal, records_changes) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto& j = g.start_journal();
+    auto& t = *g.at<R::Token>().first();
+    t.features().set<F::start_pos>(3);
+    EXPECT_FALSE(j.empty());
+    auto& w = g.at<R::Word>().append();
+    EXPECT_NO_THROW(j.id(w));
+    std::ostringstream os;
+    j.flush(os);
+    EXPECT_TRUE(j.empty());
+    const auto delta = os.str();
+    EXPECT_NE(delta.find("start_pos"), string::npos);
+    // untouched nodes are not part of delta
+    EXPECT_EQ(delta.find("baz"), string::npos);
+    g.at<R::Word>().erase(w);
+    EXPECT_THROW(j.id(w), error::bad_node);
+}
+
+TEST(journal, reads_are_not_writes) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto& j = g.start_journal();
+    auto& feats = g.at<R::Token>().first()->features();
+    EXPECT_EQ(*feats.peek<F::name>(), "foo");
+    EXPECT_EQ(*std::as_const(feats).get<F::name>(), "foo");
+    EXPECT_TRUE(j.empty());
+    *feats.get<F::name>() += "d";
+    EXPECT_FALSE(j.empty());
+    EXPECT_EQ(*feats.peek<F::name>(), "food");
+}
+
+TEST(journal, moves_with_graph) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    g.start_journal();
+    graph moved{std::move(g)};
+    EXPECT_FALSE(g.journal());
+    auto& j = *moved.journal();
+    EXPECT_EQ(&j.graph(), &moved);
+    auto& w = moved.at<R::Word>().append();
+    EXPECT_FALSE(j.empty());
+    EXPECT_NO_THROW(j.id(w));
+    std::ostringstream os;
+    EXPECT_NO_THROW(j.snapshot(os));
+}
+
+TEST(journal, replica_follows_deltas) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto& j = g.start_journal();
+    std::stringstream snapshot;
+    j.snapshot(snapshot);
+    replica r{snapshot};
+    EXPECT_EQ(names(r.graph().at<R::Token>()), names(g.at<R::Token>()));
+    EXPECT_EQ(names(r.graph().at<R::Word>()), names(g.at<R::Word>()));
+
+    // first stage: add token with word, rename one
+    auto& words = g.at<R::Word>();
+    auto& t = g.at<R::Token>().append();
+    t.features().set<F::name>("qux");
+    auto& w = words.append(&t);
+    w.set_parent(&t);
+    t.set_first_child(&w).set_last_child(&w);
+    words.first()->features().set<F::name>("BAZ");
+    std::stringstream delta;
+    j.flush(delta);
+
+    // second stage: drop first token and a feature
+    auto& tokens = g.at<R::Token>();
+    tokens.erase(*tokens.first());
+    tokens.last()->features().remove<F::name>();
+    j.flush(delta);
+
+    r.apply(delta);
+    EXPECT_EQ(names(r.graph().at<R::Token>()), names(g.at<R::Token>()));
+    EXPECT_EQ(names(r.graph().at<R::Word>()), names(g.at<R::Word>()));
+    EXPECT_EQ(r.graph().at<R::Token>().size(), tokens.size());
+    auto rw = r.graph().at<R::Word>().last();
+    ASSERT_TRUE(rw);
+    EXPECT_EQ(rw->as<R::Token>(), rw->parent());
+    EXPECT_EQ(rw->parent()->first_child(), rw);
+    EXPECT_FALSE(r.graph().at<R::Word>().first()->parent());
+}
+
+TEST(journal, replica_from_scratch) {
+    graph g;
+    auto& j = g.start_journal();
+    auto& tokens = g.at<R::Token>();
+    tokens.append().features().set<F::name>("a");
+    tokens.append().features().set<F::name>("b");
+    std::stringstream delta;
+    j.flush(delta);
+
+    replica r;
+    r.apply(delta.str());
+    EXPECT_EQ(names(r.graph().at<R::Token>()), (std::vector<string>{"a", "b"}));
+}
+
+TEST(journal, replica_follows_append_graph) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto& j = g.start_journal();
+    std::stringstream snapshot;
+    j.snapshot(snapshot);
+    replica r{snapshot};
+
+    graph other;
+    auto& t = other.at<R::Token>().append();
+    t.features().set<F::name>("qux");
+    auto& w = other.at<R::Word>().append(&t);
+    w.set_parent(&t);
+    t.set_first_child(&w).set_last_child(&w);
+    g.append_graph(std::move(other));
+    std::stringstream delta;
+    j.flush(delta);
+
+    r.apply(delta);
+    EXPECT_EQ(names(r.graph().at<R::Token>()), names(g.at<R::Token>()));
+    EXPECT_EQ(names(r.graph().at<R::Word>()), names(g.at<R::Word>()));
+    auto rw = r.graph().at<R::Word>().last();
+    ASSERT_TRUE(rw);
+    EXPECT_EQ(rw->as<R::Token>(), r.graph().at<R::Token>().last());
+    EXPECT_EQ(rw->parent(), rw->as<R::Token>());
+    EXPECT_EQ(rw->parent()->first_child(), rw);
+    EXPECT_EQ(rw->prev()->next(), rw);
+}
+
+TEST(journal, apply_throws_on_unknown_node) {
+    replica r;
+    EXPECT_THROW(r.apply("delta: { erased: [ 7 ] }"), error::parsing_error);
+    EXPECT_THROW(r.apply("nodes: []"), error::parsing_error);
+}
+}  // namespace hrglib::test
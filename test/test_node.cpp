@@ -2,15 +2,20 @@
 #include "hrglib/token.hpp"
 #include "hrglib/word.hpp"
 #include "hrglib/syllable.hpp"
+#include "hrglib/phrase.hpp"
 #include "hrglib/error.hpp"
 #include "hrglib/graph.hpp"
 #include "hrglib/node_navigator.hpp"
 #include "hrglib/relation.hpp"
 #include "hrglib/relation_name.hpp"
 
+#include "utils.hpp"
+
 #include <gtest/gtest.h>
 
 #include <type_traits>                // for is_same_v
+#include <utility>
+#include <vector>
 
 namespace hrglib::test {
 
@@ -46,6 +51,34 @@ TEST(node, duplicate_relation_throws) {
     EXPECT_THROW(g.at<R::Word>().create(&n), error::relation_exists);
 }
 
+TEST(node, erase_only_child) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    auto& t1 = g.at<R::Token>().append();
+    auto& t2 = g.at<R::Token>().append();
+    auto& w1 = words.append();
+    auto& w2 = words.append();
+    auto& w3 = words.append();
+    t1.set_first_child(&w1).set_last_child(&w1);
+    t2.set_first_child(&w2).set_last_child(&w3);
+
+    // the next sibling belongs to other parent, which keeps it
+    words.erase(w1);
+    EXPECT_FALSE(t1.first_child());
+    EXPECT_FALSE(t1.last_child());
+    EXPECT_EQ(t2.first_child(), &w2);
+    EXPECT_EQ(t2.last_child(), &w3);
+
+    // and so does the previous one
+    auto& t3 = g.at<R::Token>().append();
+    auto& w4 = words.append();
+    t3.set_first_child(&w4).set_last_child(&w4);
+    words.erase(w4);
+    EXPECT_FALSE(t3.first_child());
+    EXPECT_FALSE(t3.last_child());
+    EXPECT_EQ(t2.last_child(), &w3);
+}
+
 TEST(node_navigator, traversal_does_not_throw) {
     graph g;
     auto& n = g.at<R::Token>().create();
@@ -100,6 +133,90 @@ TEST(node, as) {
     EXPECT_EQ(s.as<word>(), nullptr);
 }
 
+TEST(node, up_and_leaves) {
+    static_assert(hierarchy_distance(R::Syllable, R::Phrase) == 3, "");
+    static_assert(hierarchy_distance(R::Word, R::Word) == 0, "");
+    static_assert(hierarchy_distance(R::Phrase, R::Word) == -1, "");
+    static_assert(hierarchy_distance(R::SylStructure, R::Word) == -1, "");
+
+    graph g;
+    auto& p = g.at<R::Phrase>().append();
+    auto& t1 = g.at<R::Token>().append();
+    auto& t2 = g.at<R::Token>().append();
+    auto& t3 = g.at<R::Token>().append();
+    auto& w1 = g.at<R::Word>().append();
+    auto& w2 = g.at<R::Word>().append();
+    auto& w3 = g.at<R::Word>().append();
+    auto& s1 = g.at<R::Syllable>().append();
+    auto& s2 = g.at<R::Syllable>().append();
+    auto& s3 = g.at<R::Syllable>().append();
+    for (auto t: {&t1, &t2, &t3}) {
+        adopt(p, *t);
+    }
+    // t2 and w2 are childless
+    adopt(t1, w1);
+    adopt(t1, w2);
+    adopt(t3, w3);
+    adopt(w1, s1);
+    adopt(w1, s2);
+    adopt(w3, s3);
+
+    static_assert(std::is_same_v<decltype(s3.up<R::Phrase>()), node_navigator<phrase>>, "");
+    EXPECT_EQ(s3.up<R::Phrase>(), &p);
+    EXPECT_EQ(s1.up<R::Token>(), &t1);
+    EXPECT_EQ(s1.up<R::Syllable>(), &s1);
+    EXPECT_EQ(std::as_const(s2).up<R::Word>(), &w1);
+    EXPECT_EQ(t3.nav().up<R::Phrase>(), &p);
+    EXPECT_EQ(s1.next().next().next().up<R::Phrase>(), nullptr);
+    auto& loose = g.at<R::Syllable>().create();
+    EXPECT_EQ(loose.up<R::Phrase>(), nullptr);
+
+    std::vector<const syllable*> sylls;
+    for (auto&& s: std::as_const(p).leaves<R::Syllable>()) {
+        sylls.push_back(&s);
+    }
+    EXPECT_EQ(sylls, (std::vector<const syllable*>{&s1, &s2, &s3}));
+    std::vector<word*> words;
+    for (auto&& w: p.leaves<R::Word>()) {
+        words.push_back(&w);
+    }
+    EXPECT_EQ(words, (std::vector<word*>{&w1, &w2, &w3}));
+    auto t2_leaves = t2.leaves<R::Syllable>();
+    EXPECT_EQ(t2_leaves.begin(), t2_leaves.end());
+    auto w3_leaves = w3.leaves<R::Syllable>();
+    EXPECT_EQ(std::distance(w3_leaves.begin(), w3_leaves.end()), 1);
+    auto self = w2.leaves<R::Word>();
+    EXPECT_EQ(&*self.begin(), &w2);
+}
+
+TEST(node, link_validation) {
+    static_assert(is_valid_link(R::Token, R::Word), "");
+    static_assert(is_valid_link(R::Phrase, R::Token), "");
+    static_assert(!is_valid_link(R::Word, R::Token), "");
+    static_assert(!is_valid_link(R::Phrase, R::Word), "");
+    static_assert(!is_valid_link(R::INVALID, R::Word), "");
+
+    graph g;
+    auto& t = g.at<R::Token>().append();
+    auto& w = g.at<R::Word>().append();
+    auto& s = g.at<R::Syllable>().append();
+    node& untyped = w;
+    EXPECT_THROW(untyped.set_parent(&s), error::bad_relation);
+    EXPECT_THROW(static_cast<node&>(t).set_first_child(&s), error::bad_relation);
+    untyped.set_parent(&t);
+    EXPECT_EQ(w.parent(), &t);
+
+    // custom validator applies to typed links too
+    auto strict = graph::builder{}.with_relation_validator([](const relation&, const relation&) { return false; }).build();
+    auto& t2 = strict.at<R::Token>().append();
+    auto& w2 = strict.at<R::Word>().append();
+    EXPECT_THROW(static_cast<node&>(w2).set_parent(&t2), error::bad_relation);
+    EXPECT_THROW(t2.set_first_child(&w2), error::bad_relation);
+    EXPECT_THROW(t2.set_last_child(&w2), error::bad_relation);
+    EXPECT_THROW(w2.set_parent(&t2), error::bad_relation);
+    EXPECT_FALSE(w2.parent());
+}
+
 // TEST(node, insert_next_prev) {
 //     auto g = make_simple_graph();
 //     auto w4 = g.at<R::Word>().insert_next();
@@ -0,0 +1,102 @@
+#include "hrglib/order_index.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/word.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+//! Check that keys and ranks agree with the order of the relation.
+void expect_consistent(order_index& idx, const relation& rel) {
+    std::size_t i = 0;
+    const node* prev = nullptr;
+    for (auto&& n: rel) {
+        EXPECT_EQ(idx.rank(n), i++);
+        if (prev != nullptr) {
+            EXPECT_TRUE(idx.precedes(*prev, n));
+            EXPECT_FALSE(idx.precedes(n, *prev));
+        }
+        prev = &n;
+    }
+}
+}  // namespace
+
+TEST(order_index, incremental) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    auto& a = words.append();
+    auto& b = words.append();
+    order_index idx{words};
+    EXPECT_TRUE(idx.precedes(a, b));
+
+    auto& c = words.append();
+    auto& z = words.prepend();
+    auto& ab = a.insert_next();
+    expect_consistent(idx, words);
+    EXPECT_EQ(idx.rank(z), 0);
+    EXPECT_EQ(idx.rank(ab), 2);
+    EXPECT_TRUE(idx.precedes(ab, c));
+
+    // move c in front of a
+    b.set_next(static_cast<word*>(nullptr));
+    words.set_last(&b);
+    z.set_next(&c);
+    c.set_next(&a);
+    expect_consistent(idx, words);
+    EXPECT_EQ(idx.rank(c), 1);
+
+    words.erase(ab);
+    a.set_next(&b);
+    expect_consistent(idx, words);
+    EXPECT_EQ(idx.rank(b), 3);
+}
+
+TEST(order_index, relabels_when_out_of_room) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    auto& first = words.append();
+    words.append();
+    order_index idx{words};
+    // always inserting at the same place halves the gap each time
+    for (int i = 0; i < 200; ++i) {
+        first.insert_next();
+        EXPECT_LT(idx.key(first), idx.key(*first.next()));
+    }
+    EXPECT_GT(idx.relabels(), 0);
+    expect_consistent(idx, words);
+}
+
+TEST(order_index, renumbers_from_first_change) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    for (int i = 0; i < 100; ++i) {
+        words.append();
+    }
+    order_index idx{words};
+    EXPECT_EQ(idx.rank(*words.last()), 99);
+    EXPECT_EQ(idx.renumbered(), 100);
+
+    // the old last node got new next
+    auto& w = words.append();
+    EXPECT_EQ(idx.rank(w), 100);
+    EXPECT_EQ(idx.renumbered(), 102);
+    // unchanged ranks are not recomputed
+    EXPECT_EQ(idx.rank(*words.first()), 0);
+    EXPECT_EQ(idx.renumbered(), 102);
+
+    auto& inserted = words.last()->prev()->insert_prev();
+    words.erase(w);
+    EXPECT_EQ(idx.rank(inserted), 99);
+    EXPECT_EQ(idx.renumbered(), 105);
+    expect_consistent(idx, words);
+
+    words.prepend();
+    expect_consistent(idx, words);
+    EXPECT_EQ(idx.renumbered(), 207);
+}
+}  // namespace hrglib::test
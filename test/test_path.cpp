@@ -0,0 +1,79 @@
+#include "hrglib/path.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+string name_of(const optional<const any&>& v) {
+    return v ? any_cast<const string&>(*v) : "?";
+}
+}  // namespace
+
+TEST(path, compile) {
+    const auto p = path::compile("R:Word.parent.n.name");
+    EXPECT_EQ(p.expression(), "R:Word.parent.n.name");
+    EXPECT_EQ(p.feature(), F::name);
+    EXPECT_EQ(p.size(), 3);
+    EXPECT_EQ(path::compile("start_pos").size(), 0);
+    EXPECT_EQ(path::compile("daughter1.first_child.daughtern.last_child.prev.p.next.name").size(), 7);
+
+    EXPECT_THROW(path::compile(""), error::invalid_path);
+    EXPECT_THROW(path::compile("n..name"), error::invalid_path);
+    EXPECT_THROW(path::compile("n.p."), error::invalid_path);
+    EXPECT_THROW(path::compile("n.p"), error::invalid_path);
+    EXPECT_THROW(path::compile("up.name"), error::invalid_path);
+    EXPECT_THROW(path::compile("R:Nope.name"), error::invalid_path);
+}
+
+TEST(path, evaluate) {
+    const auto g = graph::from_file(data_file("test_graph.yaml"));
+    const auto& foo = *g.get(R::Token)->first();
+    const auto& zaz = *g.get(R::Word)->last();
+
+    EXPECT_EQ(name_of(path::compile("name")(foo)), "foo");
+    EXPECT_EQ(name_of(path::compile("n.name")(foo)), "bar");
+    EXPECT_EQ(name_of(path::compile("daughtern.p.name")(foo)), "baz");
+    EXPECT_EQ(name_of(path::compile("parent.n.name")(zaz)), "bar");
+    EXPECT_EQ(name_of(path::compile("R:Word.name")(zaz)), "zaz");
+    // null propagates through the rest of the path
+    EXPECT_EQ(path::compile("p.p.n.n.name")(foo), nullopt);
+    EXPECT_EQ(path::compile("R:Token.name")(zaz), nullopt);
+    EXPECT_EQ(path::compile("start_pos")(foo), nullopt);
+
+    EXPECT_EQ(path::compile("parent.n.name").target(zaz), g.get(R::Token)->last());
+    EXPECT_FALSE(path::compile("R:Syllable.name").target(zaz));
+}
+
+TEST(path, evaluate_relation) {
+    const auto g = graph::from_file(data_file("test_graph.yaml"));
+    std::vector<optional<const any&>> res;
+    path::compile("parent.n.name").evaluate(*g.get(R::Word), std::back_inserter(res));
+    ASSERT_EQ(res.size(), 2);
+    EXPECT_EQ(name_of(res[0]), "bar");
+    EXPECT_EQ(name_of(res[1]), "bar");
+    res.clear();
+    path::compile("p.name").evaluate(*g.get(R::Token), std::back_inserter(res));
+    ASSERT_EQ(res.size(), 2);
+    EXPECT_EQ(res[0], nullopt);
+    EXPECT_EQ(name_of(res[1]), "foo");
+}
+
+TEST(path, cached) {
+    const auto& p = path::cached("n.name");
+    EXPECT_EQ(&path::cached(string{"n.name"}), &p);
+    EXPECT_NE(&path::cached("p.name"), &p);
+    EXPECT_THROW(path::cached("n.nope"), error::invalid_path);
+    EXPECT_THROW(path::cached("n.nope"), error::invalid_path);
+}
+}  // namespace hrglib::test
@@ -0,0 +1,66 @@
+#include "hrglib/predicate.hpp"
+#include "hrglib/node_mask.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/word.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+std::vector<std::size_t> indices(const node_mask& m) {
+    std::vector<std::size_t> res;
+    m.for_each([&](std::size_t i) { res.push_back(i); });
+    return res;
+}
+
+using idx = std::vector<std::size_t>;
+}  // namespace
+
+TEST(node_mask, set_algebra) {
+    node_mask a{130};
+    node_mask b{130, true};
+    EXPECT_EQ(b.count(), 130);
+    EXPECT_TRUE(a.none());
+    a.set(0).set(64).set(129);
+    EXPECT_EQ(indices(a), (idx{0, 64, 129}));
+    EXPECT_EQ((a & b), a);
+    EXPECT_EQ((~a).count(), 127);
+    EXPECT_EQ(indices(b - ~a), (idx{0, 64, 129}));
+    EXPECT_EQ(indices(a.shifted(1)), (idx{63, 128}));
+    EXPECT_EQ(indices(a.shifted(-1)), (idx{1, 65}));
+    a.set(64, false);
+    EXPECT_EQ(indices(a ^ node_mask{130}.set(0).set(1)), (idx{1, 129}));
+}
+
+TEST(predicate, evaluate) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    const char* names[] = {"the", "cat", ",", "sat", "on", "the", "mat", "."};
+    std::size_t pos = 0;
+    for (auto name: names) {
+        auto& w = words.append();
+        w.features().set<F::name>(name);
+        w.features().set<F::start_pos>(pos++);
+    }
+    words.first()->features().erase(F::start_pos);
+
+    EXPECT_EQ(predicate{}.evaluate(words).count(), 8);
+    EXPECT_EQ(indices(predicate::in(F::name, {"the", "mat"}).evaluate(words)), (idx{0, 5, 6}));
+    EXPECT_EQ(indices(predicate::compare(F::start_pos, comparison::less, 3).evaluate(words)), (idx{1, 2}));
+    EXPECT_EQ(indices((!predicate::has(F::start_pos)).evaluate(words)), (idx{0}));
+    const auto punc = predicate::in(F::name, {",", "."});
+    const auto p = predicate::compare(F::start_pos, comparison::greater_equal, 1) && predicate::next(punc);
+    EXPECT_EQ(indices(p.evaluate(words)), (idx{1, 6}));
+    EXPECT_EQ(indices((predicate::prev(punc) || predicate::in(F::start_pos, {"4"})).evaluate(words)), (idx{3, 4}));
+    const auto selected = p.select(words);
+    ASSERT_EQ(selected.size(), 2);
+    EXPECT_EQ(*selected[1]->features().get<F::name>(), "mat");
+    EXPECT_THROW(predicate::compare(F::name, comparison::equal, 0), std::invalid_argument);
+}
+}  // namespace hrglib::test
@@ -0,0 +1,83 @@
+#include "hrglib/rollup.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/error.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+namespace hrglib::test {
+TEST(rollup, invalid) {
+    graph g;
+    EXPECT_THROW((rollup{g, rollup_op::count, R::Word, R::Token}), std::invalid_argument);
+    EXPECT_THROW((rollup{g, rollup_op::count, R::Word, R::Word}), std::invalid_argument);
+    EXPECT_THROW((rollup{g, rollup_op::sum, R::Token, R::Word}), std::invalid_argument);
+    EXPECT_THROW((rollup{g, rollup_op::sum, R::Token, R::Word, F::name}), std::invalid_argument);
+}
+
+TEST(rollup, existing_graph) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    rollup words{g, rollup_op::count, R::Token, R::Word};
+    EXPECT_EQ(*words.get(*g.at(R::Token).first()), 2u);
+    EXPECT_EQ(*words.get(*g.at(R::Token).last()), 0u);
+    EXPECT_THROW(words.get(*g.at(R::Word).first()), error::bad_relation);
+}
+
+TEST(rollup, incremental) {
+    graph g;
+    auto& t1 = g.at<R::Token>().append();
+    auto& t2 = g.at<R::Token>().append();
+    auto& w1 = g.at<R::Word>().append();
+    auto& w2 = g.at<R::Word>().append();
+    auto& s1 = g.at<R::Syllable>().append();
+    auto& s2 = g.at<R::Syllable>().append();
+    auto& s3 = g.at<R::Syllable>().append();
+    s1.features().set<F::end_pos>(3);
+    s2.features().set<F::end_pos>(5);
+
+    rollup count{g, rollup_op::count, R::Token, R::Syllable};
+    rollup sum{g, rollup_op::sum, R::Token, R::Syllable, F::end_pos};
+    rollup min{g, rollup_op::min, R::Token, R::Syllable, F::end_pos};
+    rollup max{g, rollup_op::max, R::Token, R::Syllable, F::end_pos};
+    EXPECT_EQ(*count.get(t1), 0u);
+    EXPECT_EQ(min.get(t1), nullopt);
+
+    adopt(t1, w1);
+    adopt(w1, s1);
+    adopt(w1, s2);
+    adopt(w1, s3);
+    EXPECT_EQ(*count.get(t1), 3u);
+    EXPECT_EQ(*sum.get(t1), 8u);
+    EXPECT_EQ(*min.get(t1), 3u);
+    EXPECT_EQ(*max.get(t1), 5u);
+
+    s3.features().set<F::end_pos>(7);
+    s1.features().set<F::end_pos>(4);
+    EXPECT_EQ(*sum.get(t1), 16u);
+    EXPECT_EQ(*min.get(t1), 4u);
+    EXPECT_EQ(*max.get(t1), 7u);
+
+    // moving the intermediate node moves all its descendants
+    adopt(t2, w1);
+    EXPECT_EQ(*count.get(t1), 0u);
+    EXPECT_EQ(*sum.get(t1), 0u);
+    EXPECT_EQ(max.get(t1), nullopt);
+    EXPECT_EQ(*sum.get(t2), 16u);
+
+    adopt(w2, s3);
+    EXPECT_EQ(*count.get(t2), 2u);
+    EXPECT_EQ(*max.get(t2), 5u);
+
+    g.at(R::Syllable).erase(s2);
+    EXPECT_EQ(*sum.get(t2), 4u);
+    g.at(R::Word).erase(w1);
+    EXPECT_EQ(*count.get(t2), 0u);
+    adopt(t1, w2);
+    EXPECT_EQ(*sum.get(t1), 7u);
+}
+}  // namespace hrglib::test
@@ -0,0 +1,48 @@
+#include "hrglib/sequence_relation.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/token.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace hrglib::test {
+TEST(sequence_relation, random_access) {
+    auto g = graph::builder{}.with_relation_factory(sequence_relation_factory{R::Token}).build();
+    auto& tokens = g.at<sequence_relation_<R::Token>>();
+    EXPECT_EQ(dynamic_cast<sequence_relation_<R::Word>*>(&g.at(R::Word)), nullptr);
+    static_assert(std::is_same_v<
+            std::iterator_traits<sequence_relation_<R::Token>::iterator>::iterator_category,
+            std::random_access_iterator_tag>, "");
+
+    for (std::size_t i = 0; i < 10; ++i) {
+        tokens.append().features().set<F::start_pos>(i * 2);
+    }
+    EXPECT_EQ(tokens.length(), 10);
+    EXPECT_EQ(tokens.end() - tokens.begin(), 10);
+    EXPECT_EQ(*tokens[3].features().get<F::start_pos>(), 6);
+    EXPECT_EQ(tokens[3].next(), &tokens[4]);
+    EXPECT_THROW(tokens.at(10), std::out_of_range);
+
+    const auto it = std::lower_bound(tokens.begin(), tokens.end(), std::size_t{7},
+            [](const token& t, std::size_t pos) { return *t.features().get<F::start_pos>() < pos; });
+    EXPECT_EQ(it - tokens.begin(), 4);
+
+    // changes made through links are picked up
+    auto& t = tokens[0].insert_next();
+    EXPECT_EQ(&tokens[1], &t);
+    EXPECT_EQ(tokens.length(), 11);
+    auto& doomed = tokens[5];
+    auto& after = tokens[6];
+    EXPECT_EQ(tokens.erase_if([&](const token& x) { return &x == &doomed; }), 1);
+    EXPECT_EQ(tokens.length(), 10);
+    EXPECT_EQ(&tokens[5], &after);
+    EXPECT_EQ(tokens[4].next(), &after);
+    EXPECT_EQ(*tokens.last()->features().get<F::start_pos>(), 18);
+}
+}  // namespace hrglib::test
@@ -0,0 +1,196 @@
+#include "hrglib/shared_graph.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/word.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <functional>
+#include <system_error>
+
+namespace hrglib::test {
+namespace {
+string segment_name(const char* test) {
+    return "/hrglib-" + string{test} + "-" + std::to_string(::getpid());
+}
+
+//! Navigation performed in the consumer process, reported through exit status.
+int consume(const string& name) {
+    try {
+        const auto sg = shared_graph::acquire(name);
+        const auto t = sg.first(R::Token);
+        if (!t || t->get<F::name>() != string_view{"foo"}) {
+            return 2;
+        }
+        const auto w = t->last_child();
+        if (!w || w->get<F::name>() != string_view{"zaz"} || w->parent() != t) {
+            return 3;
+        }
+        if (t->next() != sg.last(R::Token) || sg.size(R::Word) != 2) {
+            return 4;
+        }
+        return 0;
+    } catch (...) {
+        return 1;
+    }
+}
+//! Publish test graph as @p name and let @p edit damage the image before it's acquired.
+shared_graph publish_damaged(const string& name, const std::function<void(detail::shm::header&)>& edit) {
+    auto sg = shared_graph::publish(graph::from_file(data_file("test_graph.yaml")), name);
+    const auto fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        throw std::system_error{errno, std::generic_category(), "shm_open"};
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    auto mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        throw std::system_error{errno, std::generic_category(), "mmap"};
+    }
+    edit(*static_cast<detail::shm::header*>(mem));
+    ::munmap(mem, size);
+    return sg;
+}
+
+template<typename T>
+T& mutable_entry(const T& e) {
+    return const_cast<T&>(e);
+}
+}  // namespace
+
+TEST(shared_graph, handoff_to_other_process) {
+    const auto name = segment_name("handoff");
+    auto sg = shared_graph::publish(graph::from_file(data_file("test_graph.yaml")), name);
+    EXPECT_FALSE(sg.handed_off());
+    const auto pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ::_exit(consume(name));
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_TRUE(sg.handed_off());
+    // name was removed by the consumer
+    EXPECT_THROW(shared_graph::acquire(name), std::system_error);
+}
+
+TEST(shared_graph, single_consumer) {
+    const auto name = segment_name("single");
+    auto sg = shared_graph::publish(graph::from_file(data_file("test_graph.yaml")), name);
+    EXPECT_THROW(shared_graph::publish(graph{}, name), std::system_error);
+    const auto c = shared_graph::acquire(name);
+    EXPECT_TRUE(sg.handed_off());
+    EXPECT_FALSE(c.handed_off());
+    EXPECT_THROW(shared_graph::acquire(name), std::system_error);
+}
+
+TEST(shared_graph, revoked_when_publisher_drops) {
+    const auto name = segment_name("revoked");
+    {
+        auto sg = shared_graph::publish(graph::from_file(data_file("test_graph.yaml")), name);
+    }
+    EXPECT_THROW(shared_graph::acquire(name), std::system_error);
+}
+
+TEST(shared_graph, rejects_out_of_range_image) {
+    using detail::shm::header;
+    const std::function<void(header&)> damages[] = {
+        [](header& h) { h.node_count = 1000; },
+        [](header& h) { h.strings = h.size + 1; },
+        [](header& h) { h.relations[0].first = h.node_count; },
+        [](header& h) { mutable_entry(h.node(0)).relation = static_cast<std::uint32_t>(R::COUNT); },
+        [](header& h) { mutable_entry(h.node(1)).links[0] = h.node_count; },
+        [](header& h) { mutable_entry(h.node(0)).features_end = h.feature_count + 1; },
+        [](header& h) { mutable_entry(h.feature(0)).length = 1000; },
+        // ring not closing back to the handle
+        [](header& h) { mutable_entry(h.node(0)).same_contents = 1; },
+    };
+    int i = 0;
+    for (auto&& damage: damages) {
+        SCOPED_TRACE(i);
+        const auto name = segment_name(("damaged" + std::to_string(i++)).c_str());
+        auto sg = publish_damaged(name, damage);
+        EXPECT_THROW(shared_graph::acquire(name), error::bad_handoff);
+    }
+}
+
+TEST(shared_graph, unaffected_by_later_writes) {
+    const auto name = segment_name("later");
+    auto sg = shared_graph::publish(graph::from_file(data_file("test_graph.yaml")), name);
+    // writable mapping kept past the acquisition, as the publisher's is
+    const auto fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    struct stat st;
+    ASSERT_EQ(::fstat(fd, &st), 0);
+    const auto size = static_cast<std::size_t>(st.st_size);
+    auto mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(mem, MAP_FAILED);
+    auto seg = static_cast<detail::shm::header*>(mem);
+
+    const auto c = shared_graph::acquire(name);
+    seg->relations[static_cast<std::size_t>(R::Token)].first = 1000;
+    mutable_entry(seg->node(0)).links[0] = 1000;
+    EXPECT_EQ(c.first(R::Token)->get<F::name>(), string_view{"foo"});
+    EXPECT_EQ(c.first(R::Token)->last_child()->get<F::name>(), string_view{"zaz"});
+    ::munmap(mem, size);
+}
+
+TEST(shared_graph, move_assignment) {
+    const auto name = segment_name("assigned");
+    auto sg = shared_graph::publish(graph::from_file(data_file("test_graph.yaml")), name);
+    auto other = shared_graph::publish(graph{}, segment_name("replaced"));
+    other = std::move(sg);
+    EXPECT_EQ(other.name(), name);
+    // the replaced image was revoked
+    EXPECT_THROW(shared_graph::acquire(segment_name("replaced")), std::system_error);
+    const auto c = shared_graph::acquire(name);
+    EXPECT_TRUE(other.handed_off());
+    EXPECT_EQ(c.size(R::Word), 2);
+}
+
+TEST(shared_graph, shared_contents_and_copy) {
+    graph g;
+    auto& tokens = g.at<R::Token>();
+    auto& words = g.at<R::Word>();
+    for (std::size_t i = 0; i < 100; ++i) {
+        auto& t = tokens.append();
+        t.features().set<F::name>(i % 2 ? "the" : "cat");
+        t.features().set<F::start_pos>(4 * i);
+        auto& w = words.append(&t);
+        w.set_parent(&t);
+        t.set_first_child(&w).set_last_child(&w);
+    }
+    const auto name = segment_name("contents");
+    const auto sg = shared_graph::publish(g, name);
+    const auto w = sg.last(R::Word);
+    ASSERT_TRUE(w);
+    EXPECT_EQ(w->get<F::start_pos>(), std::size_t{4 * 99});
+    EXPECT_EQ(w->as(R::Token), w->parent());
+    EXPECT_EQ(w->as(R::Word), w);
+    EXPECT_FALSE(w->as(R::Syllable));
+
+    auto copy = sg.to_graph();
+    ASSERT_EQ(copy.at<R::Word>().size(), 100);
+    auto& cw = *copy.at<R::Word>().last();
+    EXPECT_EQ(&cw.features(), &cw.as<R::Token>()->features());
+    EXPECT_EQ(cw.features().at<F::name>(), "the");
+    EXPECT_EQ(cw.parent(), copy.at<R::Token>().last());
+}
+}  // namespace hrglib::test
@@ -0,0 +1,55 @@
+#include "hrglib/side_table.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/word.hpp"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+namespace hrglib::test {
+TEST(side_table, dense_ids) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    auto& w0 = words.append();
+    auto& w1 = words.append();
+    auto& w2 = words.append();
+    auto& t0 = g.at<R::Token>().append(&w1);
+    EXPECT_EQ(w0.id(), 0);
+    EXPECT_EQ(w1.id(), 1);
+    EXPECT_EQ(w2.id(), 2);
+    // ids are per relation
+    EXPECT_EQ(t0.id(), 0);
+    EXPECT_EQ(words.id_bound(), 3);
+
+    words.erase(w1);
+    auto& w3 = words.append();
+    EXPECT_EQ(w3.id(), 1);
+    EXPECT_EQ(words.id_bound(), 3);
+    EXPECT_EQ(words.append().id(), 3);
+    EXPECT_EQ(words.id_bound(), 4);
+}
+
+TEST(side_table, values) {
+    graph g;
+    auto& words = g.at<R::Word>();
+    auto& w0 = words.append();
+    auto& w1 = words.append();
+
+    side_table<int> t{-1};
+    EXPECT_EQ(t.size(), 0);
+    EXPECT_EQ(t[w1], -1);
+    t[w1] = 5;
+    EXPECT_EQ(t.size(), 2);
+    EXPECT_EQ(std::as_const(t)[w0], -1);
+    EXPECT_EQ(t.get(w1), 5);
+    t.reset(w1);
+    EXPECT_EQ(t.get(w1), -1);
+
+    auto& w2 = words.append();
+    const side_table<int> sized{words, 7};
+    EXPECT_EQ(sized.size(), 3);
+    EXPECT_EQ(sized[w2], 7);
+}
+}  // namespace hrglib::test
@@ -0,0 +1,104 @@
+#include "hrglib/stream.hpp"
+#include "hrglib/journal.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/word.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/feature_name.hpp"
+#include "hrglib/error.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+node& add_token(graph& g, const string& name, std::initializer_list<string> words) {
+    auto& t = g.at<R::Token>().append();
+    t.features().set<F::name>(name);
+    t.features().set<F::start_pos>(name.size());
+    for (auto&& word: words) {
+        auto& w = g.at<R::Word>().append();
+        w.features().set<F::name>(word);
+        w.set_parent(&t);
+        if (!t.first_child()) {
+            t.set_first_child(&w);
+        }
+        t.set_last_child(&w);
+    }
+    return t;
+}
+
+const stream_format formats[] = {stream_format::yaml, stream_format::json, stream_format::binary};
+}  // namespace
+
+TEST(stream, replica_follows_finalized_prefix) {
+    for (auto fmt: formats) {
+        graph g;
+        std::stringstream ss;
+        stream_writer sw{g, ss, fmt};
+        replica r;
+        auto& t1 = add_token(g, "can't", {"can", "not"});
+        sw.finalize(t1);
+        EXPECT_EQ(sw.id(t1), 0);
+        auto& t2 = add_token(g, "go", {"go"});
+        EXPECT_THROW(sw.id(t2), error::bad_node);
+
+        ASSERT_TRUE(r.apply_next(ss, fmt));
+        EXPECT_FALSE(r.apply_next(ss, fmt));
+        ss.clear();
+        auto& rg = r.graph();
+        EXPECT_EQ(names(rg.at<R::Token>()), (std::vector<string>{"can't"}));
+        EXPECT_EQ(names(rg.at<R::Word>()), (std::vector<string>{"can", "not"}));
+        EXPECT_EQ(rg.at<R::Token>().first()->features().at<F::start_pos>(), 5);
+        EXPECT_EQ(rg.at<R::Word>().last()->parent(), rg.at<R::Token>().first());
+
+        add_token(g, "home", {"home"});
+        g.at<R::Token>().create().features().set<F::name>("loose");
+        sw.close();
+        EXPECT_THROW(sw.finalize(t2), std::logic_error);
+        ASSERT_TRUE(r.apply_next(ss, fmt));
+        EXPECT_EQ(names(rg.at<R::Token>()), names(g.at<R::Token>()));
+        EXPECT_EQ(names(rg.at<R::Word>()), names(g.at<R::Word>()));
+        EXPECT_EQ(rg.at<R::Token>().size(), 4);
+        EXPECT_EQ(rg.at<R::Token>().last()->last_child(), rg.at<R::Word>().last());
+    }
+}
+
+TEST(stream, finalize_unreachable_throws) {
+    graph g;
+    std::ostringstream os;
+    stream_writer sw{g, os};
+    auto& t = add_token(g, "a", {});
+    auto& loose = g.at<R::Token>().create();
+    EXPECT_THROW(sw.finalize(loose), error::bad_node);
+    EXPECT_TRUE(os.str().empty());
+    sw.finalize(t).finalize(t);
+    EXPECT_NE(os.str().find("delta"), string::npos);
+}
+
+TEST(stream, journal_deltas_in_all_formats) {
+    for (auto fmt: formats) {
+        graph g;
+        auto& j = g.start_journal();
+        add_token(g, "a", {"a"});
+        std::stringstream ss;
+        j.flush(ss, fmt);
+        g.at<R::Token>().first()->features().remove<F::start_pos>();
+        add_token(g, "b", {});
+        j.flush(ss, fmt);
+
+        replica r;
+        r.apply(ss, fmt);
+        EXPECT_EQ(names(r.graph().at<R::Token>()), (std::vector<string>{"a", "b"}));
+        EXPECT_FALSE(r.graph().at<R::Token>().first()->features().has(F::start_pos));
+    }
+}
+}  // namespace hrglib::test
@@ -0,0 +1,77 @@
+#include "hrglib/tensor_export.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace hrglib::test {
+namespace {
+struct fixture {
+    graph g;
+    token& t1 = g.at<R::Token>().append();
+    token& t2 = g.at<R::Token>().append();
+    word& w1 = g.at<R::Word>().append();
+    word& w2 = g.at<R::Word>().append();
+    word& w3 = g.at<R::Word>().append();
+
+    fixture() {
+        w1.set_parent(&t1);
+        w2.set_parent(&t2);
+        t1.set_first_child(&w1);
+        t2.set_first_child(&w2);
+        t2.set_last_child(&w2);
+        std::size_t pos = 0;
+        for (auto w: {&w1, &w2, &w3}) {
+            w->features().set<F::start_pos>(pos);
+            w->features().set<F::end_pos>(pos += 2);
+        }
+        w2.features().erase(F::end_pos);
+    }
+};
+}  // namespace
+
+TEST(tensor_export, row_major) {
+    fixture f;
+    tensor_export e{f.g.at(R::Word), {F::start_pos, F::end_pos}};
+    EXPECT_EQ(e.rows(), 3);
+    EXPECT_EQ(e.columns(), 2);
+    std::vector<float> out(e.size());
+    e.fill(out.data(), out.size(), -1);
+    EXPECT_EQ(out, (std::vector<float>{0, 2, 2, -1, 4, 6}));
+    EXPECT_THROW(e.fill(out.data(), out.size() - 1), std::invalid_argument);
+    EXPECT_THROW((tensor_export{f.g.at(R::Word), {F::name}}), std::invalid_argument);
+}
+
+TEST(tensor_export, context_window) {
+    fixture f;
+    tensor_export e{f.g.at(R::Word), {F::start_pos}};
+    e.context(1, 1).layout(tensor_layout::columnar);
+    EXPECT_EQ(e.columns(), 3);
+    EXPECT_EQ(e.column(F::start_pos, -1), 0);
+    EXPECT_EQ(e.column(F::start_pos, 1), 2);
+    EXPECT_THROW(e.column(F::start_pos, 2), std::out_of_range);
+    EXPECT_THROW(e.column(F::end_pos), std::out_of_range);
+    std::vector<double> out(e.size());
+    e.fill(out.data(), out.size(), -1);
+    EXPECT_EQ(out, (std::vector<double>{
+        -1, 0, 2,
+        0, 2, 4,
+        2, 4, -1,
+    }));
+}
+
+TEST(tensor_export, ancestors) {
+    fixture f;
+    tensor_export e{f.g.at(R::Word), {}};
+    std::vector<std::int64_t> out(e.rows());
+    e.fill_ancestors(R::Token, out.data(), out.size());
+    EXPECT_EQ(out, (std::vector<std::int64_t>{0, 1, -1}));
+    EXPECT_THROW(e.fill_ancestors(R::Syllable, out.data(), out.size()), std::invalid_argument);
+}
+}  // namespace hrglib::test
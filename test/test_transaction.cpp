@@ -0,0 +1,117 @@
+#include "hrglib/transaction.hpp"
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/token.hpp"
+#include "hrglib/word.hpp"
+#include "hrglib/string.hpp"
+
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+
+namespace hrglib::test {
+TEST(transaction, commit) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    {
+        graph::transaction tx{g};
+        g.at<R::Token>().first()->features().set<F::name>("qux");
+        EXPECT_EQ(tx.size(), 1);
+        tx.commit();
+        EXPECT_FALSE(tx.active());
+        EXPECT_EQ(tx.size(), 0);
+    }
+    EXPECT_EQ(*g.at<R::Token>().first()->features().get<F::name>(), "qux");
+}
+
+TEST(transaction, links_and_features) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    const auto before = dump(g);
+    auto& foo = *g.at<R::Token>().first();
+    auto& baz = *g.at<R::Word>().first();
+    auto& zaz = *g.at<R::Word>().last();
+    {
+        graph::transaction tx{g};
+        foo.features().set<F::name>("qux");
+        baz.features().erase(F::name);
+        zaz.features().set<F::punc>(",");
+        zaz.set_parent(g.at<R::Token>().last());
+        foo.set_last_child(&baz);
+        g.at<R::Word>().set_first(&zaz);
+        EXPECT_NE(dump(g), before);
+    }
+    EXPECT_EQ(dump(g), before);
+    EXPECT_FALSE(zaz.features().get<F::punc>());
+    EXPECT_EQ(zaz.parent(), &foo);
+}
+
+TEST(transaction, created_and_erased) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    const auto before = dump(g);
+    auto& foo = *g.at<R::Token>().first();
+    auto& bar = *g.at<R::Token>().last();
+    const node* baz = g.at<R::Word>().first();
+    graph::transaction tx{g};
+    g.at<R::Token>().erase(foo);
+    auto& qux = g.at<R::Word>().append();
+    qux.features().set<F::name>("qux");
+    qux.set_parent(&bar);
+    bar.set_first_child(&qux);
+    auto& n = g.at<R::Token>().append();
+    n.features().set<F::name>("new");
+    g.at<R::Word>().erase_if([](word& w) {
+        auto name = w.features().peek<F::name>();
+        return name && *name == "baz";
+    });
+    EXPECT_NE(dump(g), before);
+    tx.rollback();
+    EXPECT_EQ(dump(g), before);
+    EXPECT_EQ(g.at<R::Token>().size(), 2);
+    EXPECT_EQ(g.at<R::Word>().size(), 2);
+    EXPECT_EQ(name_of(tx.restored(baz)), "baz");
+    EXPECT_EQ(tx.restored(&bar), &bar);
+    tx.rollback();
+    EXPECT_EQ(dump(g), before);
+}
+
+TEST(transaction, erased_shared_contents) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    auto& t = g.at<R::Token>().append();
+    auto& w = g.at<R::Word>().append(&t);
+    w.features().set<F::name>("both");
+    const auto before = dump(g);
+    {
+        graph::transaction tx{g};
+        g.at<R::Word>().erase(w);
+        g.at<R::Token>().erase(t);
+        auto& n = g.at<R::Token>().append();
+        n.features().set<F::name>("other");
+    }
+    EXPECT_EQ(dump(g), before);
+    EXPECT_EQ(name_of(g.at<R::Word>().last()->as(R::Token)), "both");
+}
+
+TEST(transaction, nested) {
+    auto g = graph::from_file(data_file("test_graph.yaml"));
+    const auto before = dump(g);
+    graph::transaction outer{g};
+    g.at<R::Token>().first()->features().set<F::name>("outer");
+    const auto middle = dump(g);
+    {
+        graph::transaction inner{g};
+        g.at<R::Word>().erase(*g.at<R::Word>().first());
+        g.at<R::Token>().last()->features().set<F::name>("inner");
+    }
+    EXPECT_EQ(dump(g), middle);
+    {
+        graph::transaction inner{g};
+        g.at<R::Token>().append().features().set<F::name>("kept");
+        inner.commit();
+    }
+    EXPECT_NE(dump(g), middle);
+    outer.rollback();
+    EXPECT_EQ(dump(g), before);
+}
+}  // namespace hrglib::test
@@ -1,7 +1,13 @@
 #pragma once
+#include "hrglib/graph.hpp"
+#include "hrglib/node.hpp"
+#include "hrglib/relation.hpp"
+#include "hrglib/relation_name.hpp"
+#include "hrglib/string.hpp"
 
 #include <string>
 #include <cstdlib>
+#include <vector>
 
 namespace hrglib::test {
 
@@ -20,4 +26,49 @@ inline string data_file(Str&& str) {
     return data_dir() + "/" + std::forward<Str>(str);
 }
 
+//! Append @p c to the children of @p p.
+template<class Parent, class Child>
+void adopt(Parent& p, Child& c) {
+    c.set_parent(&p);
+    if (!p.first_child()) {
+        p.set_first_child(&c);
+    }
+    p.set_last_child(&c);
+}
+
+inline std::vector<string> names(const relation& r) {
+    std::vector<string> res;
+    for (auto&& n: r) {
+        auto name = n.features().get<F::name>();
+        res.push_back(name ? *name : "?");
+    }
+    return res;
+}
+
+inline string name_of(node::const_navigator n) {
+    if (!n) {
+        return "-";
+    }
+    auto name = n->features().get<F::name>();
+    return name ? string{*name} : "?";
+}
+
+//! Address- and id-independent description of the sequences, hierarchy and names.
+inline string dump(const graph& g) {
+    string res;
+    for (auto rel: {R::Token, R::Word}) {
+        auto r = g.get(rel);
+        if (!r) {
+            continue;
+        }
+        res += to_string(rel) + "[" + std::to_string(r->size()) + "]:";
+        for (auto n = r->first(); n; n = n->next()) {
+            res += " " + name_of(n) + "(" + name_of(n->parent()) + " " + name_of(n->first_child())
+                    + " " + name_of(n->last_child()) + " " + name_of(n->as(R::Token)) + ")";
+        }
+        res += " last " + name_of(r->last()) + "\n";
+    }
+    return res;
+}
+
 }